@@ -12,7 +12,7 @@ create_cubemap(char *file_pattern) {
     strcpy(cubemap->file_pattern, file_pattern);
 
     glGenTextures(1, &cubemap->texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->texture);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_CUBE_MAP, cubemap->texture);
 
     char *name_buffer = malloc(strlen(file_pattern) + 1 + 4);
     SDL_ALLOC_CHECK(name_buffer)
@@ -55,7 +55,7 @@ destroy_cubemap(cubemap_t **p_cubemap) {
     }
 
     if (cubemap->texture >= 0) {
-        glDeleteTextures(1, &cubemap->texture);
+        gl_delete_textures(1, &cubemap->texture);
         cubemap->texture = -1;
     }
 
@@ -1,5 +1,7 @@
 #include "gl_ext.h"
 
+bool gl_strict_errors = true;
+
 void
 glCheckError(const char *file, int line) {
     GLenum error = glGetError();
@@ -7,3 +9,34 @@ glCheckError(const char *file, int line) {
         SDL_Die("OpenGl error %x in %s at %d\n", error, file, line);
     }
 }
+
+static void GL_APIENTRY
+log_gl_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message,
+                     const void *user_param) {
+    if (type == GL_DEBUG_TYPE_ERROR) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "OpenGl error %x: %s", id, message);
+    } else if (severity == GL_DEBUG_SEVERITY_HIGH) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "OpenGl message %x: %s", id, message);
+    } else {
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "OpenGl message %x: %s", id, message);
+    }
+}
+
+void
+init_gl_errors(bool strict) {
+    if (!SDL_GL_ExtensionSupported("GL_KHR_debug")) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "No KHR_debug, checking glGetError() after GL calls");
+        gl_strict_errors = true;
+        return;
+    }
+    glEnable(GL_DEBUG_OUTPUT);
+    if (strict) {
+        // messages are reported inside the failing call
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    glDebugMessageCallback(log_gl_debug_message, NULL);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+    gl_strict_errors = strict;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "OpenGl errors reported through KHR_debug%s",
+                strict ? ", strict glGetError() checks" : "");
+}
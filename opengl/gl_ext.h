@@ -1,12 +1,38 @@
 #ifndef SDL_TEST_GL_EXT_H
 #define SDL_TEST_GL_EXT_H
 
+#include <stdbool.h>
 #include <GLES3/gl32.h>
 #include "cglm_ext.h"
 #include "sdl_ext.h"
 
-#define GL_CHECK_ERROR glCheckError(__FILE__, __LINE__)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/**
+ * glGetError() is a sync point on many drivers, so it is only called after GL calls in strict mode. Otherwise errors
+ * arrive through the KHR_debug callback installed by init_gl_errors(). Building with GL_ERROR_CHECKS_DISABLED
+ * compiles the checks out.
+ */
+#ifdef GL_ERROR_CHECKS_DISABLED
+#define GL_CHECK_ERROR ((void) 0)
+#else
+#define GL_CHECK_ERROR do { if (gl_strict_errors) glCheckError(__FILE__, __LINE__); } while (0)
+#endif
+
+/**
+ * true until init_gl_errors() finds debug output, and in strict mode
+ */
+extern bool gl_strict_errors;
 
 void glCheckError(const char *file, int line);
 
+/**
+ * Routes errors through glDebugMessageCallback when KHR_debug is available. Strict mode also checks glGetError() at
+ * each GL_CHECK_ERROR to die at the failing call, and should be requested with a debug context.
+ */
+void init_gl_errors(bool strict);
+
 #endif //SDL_TEST_GL_EXT_H
@@ -0,0 +1,219 @@
+#include "gl_state.h"
+#include <GL/gl.h>
+
+#define TEXTURE_TARGETS 2
+
+typedef struct tracked_value {
+    bool known;
+    GLuint value;
+} tracked_value_t;
+
+typedef struct tracked_capability {
+    GLenum capability;
+    tracked_value_t enabled;
+} tracked_capability_t;
+
+static tracked_value_t program;
+static tracked_value_t vertex_array;
+static tracked_value_t frame_buffer;
+static tracked_value_t active_texture;
+static tracked_value_t textures[GL_STATE_TEXTURE_UNITS][TEXTURE_TARGETS];
+static tracked_value_t polygon_mode;
+static tracked_value_t depth_func;
+static tracked_capability_t capabilities[] = {
+        {GL_DEPTH_TEST},
+        {GL_BLEND},
+        {GL_CULL_FACE},
+        {GL_STENCIL_TEST}
+};
+
+static gl_state_counters_t counters;
+
+/**
+ * Returns true when the call has to be issued, the shadow then holds the new value
+ */
+static bool
+update_tracked_value(tracked_value_t *tracked, GLuint value) {
+    if (tracked->known && tracked->value == value) {
+        counters.elided++;
+        return false;
+    }
+    tracked->known = true;
+    tracked->value = value;
+    counters.issued++;
+    return true;
+}
+
+/**
+ * Marks a binding the driver reset to 0 when the bound object was deleted
+ */
+static void
+reset_deleted_binding(tracked_value_t *tracked, GLuint deleted) {
+    if (tracked->known && tracked->value == deleted) {
+        tracked->value = 0;
+    }
+}
+
+void
+gl_use_program(GLuint id) {
+    if (update_tracked_value(&program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void
+gl_bind_vertex_array(GLuint id) {
+    if (update_tracked_value(&vertex_array, id)) {
+        glBindVertexArray(id);
+    }
+}
+
+void
+gl_bind_framebuffer(GLenum target, GLuint id) {
+    if (target != GL_FRAMEBUFFER) {
+        // binds only one of the draw and read bindings tracked together
+        frame_buffer.known = false;
+        counters.issued++;
+        glBindFramebuffer(target, id);
+        return;
+    }
+    if (update_tracked_value(&frame_buffer, id)) {
+        glBindFramebuffer(target, id);
+    }
+}
+
+void
+gl_active_texture(GLenum unit) {
+    if (update_tracked_value(&active_texture, unit)) {
+        glActiveTexture(unit);
+    }
+}
+
+static int
+get_texture_target_index(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_CUBE_MAP:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+void
+gl_bind_texture(GLenum unit, GLenum target, GLuint id) {
+    unsigned int unit_index = unit - GL_TEXTURE0;
+    int target_index = get_texture_target_index(target);
+    if (unit_index >= GL_STATE_TEXTURE_UNITS || target_index < 0) {
+        gl_active_texture(unit);
+        counters.issued++;
+        glBindTexture(target, id);
+        return;
+    }
+    tracked_value_t *tracked = &textures[unit_index][target_index];
+    if (tracked->known && tracked->value == id) {
+        counters.elided++;
+        return;
+    }
+    gl_active_texture(unit);
+    update_tracked_value(tracked, id);
+    glBindTexture(target, id);
+}
+
+static tracked_value_t *
+find_capability(GLenum capability) {
+    for (int i = 0; i < SDL_arraysize(capabilities); i++) {
+        if (capabilities[i].capability == capability) {
+            return &capabilities[i].enabled;
+        }
+    }
+    return NULL;
+}
+
+void
+gl_enable(GLenum capability) {
+    tracked_value_t *enabled = find_capability(capability);
+    if (enabled == NULL) {
+        counters.issued++;
+        glEnable(capability);
+    } else if (update_tracked_value(enabled, GL_TRUE)) {
+        glEnable(capability);
+    }
+}
+
+void
+gl_disable(GLenum capability) {
+    tracked_value_t *enabled = find_capability(capability);
+    if (enabled == NULL) {
+        counters.issued++;
+        glDisable(capability);
+    } else if (update_tracked_value(enabled, GL_FALSE)) {
+        glDisable(capability);
+    }
+}
+
+void
+gl_polygon_mode(GLenum face, GLenum mode) {
+    if (face != GL_FRONT_AND_BACK) {
+        // front and back modes differ now
+        polygon_mode.known = false;
+        counters.issued++;
+        glPolygonMode(face, mode);
+        return;
+    }
+    if (update_tracked_value(&polygon_mode, mode)) {
+        glPolygonMode(face, mode);
+    }
+}
+
+void
+gl_depth_func(GLenum func) {
+    if (update_tracked_value(&depth_func, func)) {
+        glDepthFunc(func);
+    }
+}
+
+void
+gl_delete_program(GLuint id) {
+    if (program.known && program.value == id) {
+        // a deleted program stays in use until another one is, so a reused name must be used again
+        program.known = false;
+    }
+    glDeleteProgram(id);
+}
+
+void
+gl_delete_vertex_arrays(GLsizei number, const GLuint *ids) {
+    for (GLsizei i = 0; i < number; i++) {
+        reset_deleted_binding(&vertex_array, ids[i]);
+    }
+    glDeleteVertexArrays(number, ids);
+}
+
+void
+gl_delete_framebuffers(GLsizei number, const GLuint *ids) {
+    for (GLsizei i = 0; i < number; i++) {
+        reset_deleted_binding(&frame_buffer, ids[i]);
+    }
+    glDeleteFramebuffers(number, ids);
+}
+
+void
+gl_delete_textures(GLsizei number, const GLuint *ids) {
+    for (GLsizei i = 0; i < number; i++) {
+        for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) {
+            for (int target = 0; target < TEXTURE_TARGETS; target++) {
+                reset_deleted_binding(&textures[unit][target], ids[i]);
+            }
+        }
+    }
+    glDeleteTextures(number, ids);
+}
+
+void
+take_gl_state_counters(gl_state_counters_t *taken_counters) {
+    *taken_counters = counters;
+    counters.issued = 0;
+    counters.elided = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef SDL_TEST_GL_STATE_H
+#define SDL_TEST_GL_STATE_H
+
+#include "gl_ext.h"
+
+/**
+ * Texture units with tracked bindings, binds to higher units are always issued
+ */
+#define GL_STATE_TEXTURE_UNITS 16
+
+/**
+ * Binding and capability calls that reached the driver and calls dropped because the state was already set
+ */
+typedef struct gl_state_counters {
+    unsigned long issued;
+    unsigned long elided;
+} gl_state_counters_t;
+
+/**
+ * The functions below shadow the state of the current context and skip calls that would not change it. Every
+ * binding, tracked capability and polygon mode change must go through them, a direct GL call leaves the shadow stale.
+ * Tracking starts unknown, so the first call of each kind is always issued.
+ */
+void gl_use_program(GLuint program);
+
+void gl_bind_vertex_array(GLuint vertex_array);
+
+void gl_bind_framebuffer(GLenum target, GLuint frame_buffer);
+
+void gl_active_texture(GLenum unit);
+
+/**
+ * Binds GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP textures to unit. The unit is made active only when the bind is
+ * issued, call gl_active_texture() first when the following calls edit the bound texture.
+ */
+void gl_bind_texture(GLenum unit, GLenum target, GLuint texture);
+
+/**
+ * Tracks GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE and GL_STENCIL_TEST, other capabilities are passed through
+ */
+void gl_enable(GLenum capability);
+
+void gl_disable(GLenum capability);
+
+void gl_polygon_mode(GLenum face, GLenum mode);
+
+void gl_depth_func(GLenum func);
+
+/**
+ * Deleting objects resets the bindings GL resets, so a reused name is bound again
+ */
+void gl_delete_program(GLuint program);
+
+void gl_delete_vertex_arrays(GLsizei number, const GLuint *vertex_arrays);
+
+void gl_delete_framebuffers(GLsizei number, const GLuint *frame_buffers);
+
+void gl_delete_textures(GLsizei number, const GLuint *textures);
+
+/**
+ * Copies the counters of the calls since the previous take and resets them, callers divide by their frames
+ */
+void take_gl_state_counters(gl_state_counters_t *taken_counters);
+
+#endif //SDL_TEST_GL_STATE_H
@@ -2,12 +2,8 @@
 
 #include "model.h"
 
-#define MIN_TEXTURE_TYPE aiTextureType_DIFFUSE
-#define MAX_TEXTURE_TYPE aiTextureType_REFLECTION
-#define MAX_TEXTURES_PER_TYPE 2
 #define TEXTURE_SLOT_NAME_SIZE 24
 
-static bool texture_uniform_names_initialized = false;
 static char texture_uniform_names_templates[MAX_TEXTURE_TYPE + 1][TEXTURE_SLOT_NAME_SIZE] = {
         "texture_none%u",
         "texture_diffuse%u",
@@ -23,30 +19,13 @@ static char texture_uniform_names_templates[MAX_TEXTURE_TYPE + 1][TEXTURE_SLOT_N
         "texture_reflection%u"
 };
 
-
-static char texture_uniform_names[MAX_TEXTURE_TYPE + 1][MAX_TEXTURES_PER_TYPE][TEXTURE_SLOT_NAME_SIZE];
-static char texture_flags_names[MAX_TEXTURE_TYPE + 1][TEXTURE_SLOT_NAME_SIZE] = {
-        "textures_number[0]",
-        "textures_number[1]",
-        "textures_number[2]",
-        "textures_number[3]",
-        "textures_number[4]",
-        "textures_number[5]",
-        "textures_number[6]",
-        "textures_number[7]",
-        "textures_number[8]",
-        "textures_number[9]",
-        "textures_number[10]",
-        "textures_number[11]"
-};
-
 static void
 init_mesh_gl(mesh_t *mesh) {
     glGenVertexArrays(1, &mesh->vertex_array);
     glGenBuffers(1, &mesh->vertex_buffer);
     glGenBuffers(1, &mesh->element_buffer);
 
-    glBindVertexArray(mesh->vertex_array);
+    gl_bind_vertex_array(mesh->vertex_array);
 
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vertex_buffer);
     glBufferData(GL_ARRAY_BUFFER, mesh->vertices_number * (long) sizeof(vertex_t), mesh->vertices, GL_STATIC_DRAW);
@@ -65,87 +44,94 @@ init_mesh_gl(mesh_t *mesh) {
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void *) offsetof(vertex_t, texture_position));
 
-    glBindVertexArray(0);
+    gl_bind_vertex_array(0);
 }
 
-inline static void
-init_texture_uniform_names() {
-    if (texture_uniform_names_initialized) {
-        return;
+static mesh_uniforms_t *
+get_mesh_uniforms(shader_t *shader) {
+    mesh_uniforms_t *uniforms = &shader->mesh_uniforms;
+    if (uniforms->resolved) {
+        return uniforms;
     }
-    for (int type = MIN_TEXTURE_TYPE; type <= MAX_TEXTURE_TYPE; type++) {
-        for (int i = 0; i < MAX_TEXTURES_PER_TYPE; i++) {
-            sprintf(texture_uniform_names[type][i], texture_uniform_names_templates[type], i);
+    for (unsigned int type = 0; type <= MAX_TEXTURE_TYPE; type++) {
+        const char *name_template = texture_uniform_names_templates[type];
+        for (unsigned int i = 0; i < MAX_TEXTURES_PER_TYPE; i++) {
+            uniforms->textures[type][i] = shader_get_uniform_array_item(shader, name_template, i);
         }
-    }
-    texture_uniform_names_initialized = true;
+        uniforms->textures_number[type] = shader_get_uniform_array_item(shader, "textures_number[%u]", type);
+    }
+    uniforms->skybox = shader_get_uniform(shader, "skybox");
+    uniforms->material_ambient = shader_get_uniform(shader, "material.ambient");
+    uniforms->material_diffuse = shader_get_uniform(shader, "material.diffuse");
+    uniforms->material_specular = shader_get_uniform(shader, "material.specular");
+    uniforms->material_emissive = shader_get_uniform(shader, "material.emissive");
+    uniforms->material_shininess = shader_get_uniform(shader, "material.shininess");
+    uniforms->material_opacity = shader_get_uniform(shader, "material.opacity");
+    uniforms->index_color = shader_get_uniform(shader, "index_color");
+    uniforms->resolved = true;
+    return uniforms;
 }
 
-static char *
-get_texture_uniform_name(enum aiTextureType type, unsigned int index) {
-    init_texture_uniform_names();
+static shader_uniform_t
+get_texture_uniform(mesh_uniforms_t *uniforms, enum aiTextureType type, unsigned int index) {
     if (type > MAX_TEXTURE_TYPE) {
         SDL_Die("Texture type: %u is not supported, max supported type is %u", type, MAX_TEXTURE_TYPE);
     }
     if (index >= MAX_TEXTURES_PER_TYPE) {
         SDL_Die("You can't have more than %u textures of a single type, requested %u", MAX_TEXTURES_PER_TYPE, index);
     }
-    return texture_uniform_names[type][index];
+    return uniforms->textures[type][index];
 }
 
 static void
 render_mesh(mesh_t *mesh, rendering_context_t *context) {
     shader_t *shader = context->shader;
+    mesh_uniforms_t *uniforms = get_mesh_uniforms(shader);
     if (context->add_textures) {
         // textures
         unsigned int type_index[MAX_TEXTURE_TYPE + 1] = {0};
         int textures_count = 0;
         if (mesh->textures_number) {
             for (; textures_count < mesh->textures_number; textures_count++) {
-                glActiveTexture(GL_TEXTURE0 + textures_count);
                 texture_t *texture = mesh->textures[textures_count];
-                char *texture_uniform_name = get_texture_uniform_name(texture->type, type_index[texture->type]++);
-                shader_set_int(shader, texture_uniform_name, textures_count);
-                glBindTexture(GL_TEXTURE_2D, texture->id);
+                shader_uniform_t texture_uniform = get_texture_uniform(uniforms, texture->type,
+                                                                       type_index[texture->type]++);
+                shader_set_uniform_int(shader, texture_uniform, textures_count);
+                gl_bind_texture(GL_TEXTURE0 + textures_count, GL_TEXTURE_2D, texture->id);
             }
-            glActiveTexture(GL_TEXTURE0);
         }
         for (int i = 0; i <= MAX_TEXTURE_TYPE; i++) {
-            shader_set_int(shader, texture_flags_names[i], (int) type_index[i]);
+            shader_set_uniform_int(shader, uniforms->textures_number[i], (int) type_index[i]);
         }
         if (context->skybox_texture > 0 && type_index[aiTextureType_REFLECTION] > 0) {
-            glActiveTexture(GL_TEXTURE0 + textures_count);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, context->skybox_texture);
-            shader_set_int(shader, "skybox", textures_count);
-            glActiveTexture(GL_TEXTURE0);
+            gl_bind_texture(GL_TEXTURE0 + textures_count, GL_TEXTURE_CUBE_MAP, context->skybox_texture);
+            shader_set_uniform_int(shader, uniforms->skybox, textures_count);
         }
     }
 
     if (context->add_material_properties) {
         // material properties
-        shader_set_vec4(shader, "material.ambient", mesh->material.ambient);
-        shader_set_vec4(shader, "material.diffuse", mesh->material.diffuse);
-        shader_set_vec4(shader, "material.specular", mesh->material.specular);
-        shader_set_vec4(shader, "material.emissive", mesh->material.emissive);
-        shader_set_float(shader, "material.shininess", mesh->material.shininess);
-        shader_set_float(shader, "material.opacity", mesh->material.opacity);
+        shader_set_uniform_vec4(shader, uniforms->material_ambient, mesh->material.ambient);
+        shader_set_uniform_vec4(shader, uniforms->material_diffuse, mesh->material.diffuse);
+        shader_set_uniform_vec4(shader, uniforms->material_specular, mesh->material.specular);
+        shader_set_uniform_vec4(shader, uniforms->material_emissive, mesh->material.emissive);
+        shader_set_uniform_float(shader, uniforms->material_shininess, mesh->material.shininess);
+        shader_set_uniform_float(shader, uniforms->material_opacity, mesh->material.opacity);
     }
 
     if (context->add_index_color) {
-        shader_set_vec3(shader, "index_color", context->index_color);
+        shader_set_uniform_vec3(shader, uniforms->index_color, context->index_color);
     }
 
-    // draw
-    glBindVertexArray(mesh->vertex_array);
+    // draw, the vertex array is left bound, so binding it again is elided
+    gl_bind_vertex_array(mesh->vertex_array);
     glDrawElements(GL_TRIANGLES, (int) mesh->indices_number, GL_UNSIGNED_INT, 0);
     GL_CHECK_ERROR;
-
-    glBindVertexArray(0);
 }
 
 static void
 destroy_texture(texture_t *texture) {
-    glDeleteTextures(1, &texture->id);
+    gl_delete_textures(1, &texture->id);
     free(texture->filename);
     texture->filename = NULL;
 }
@@ -168,7 +154,7 @@ destroy_mesh_content(mesh_t *mesh) {
         mesh->textures = NULL;
     }
     if (mesh->vertex_array >= 0) {
-        glDeleteVertexArrays(1, &mesh->vertex_array);
+        gl_delete_vertex_arrays(1, &mesh->vertex_array);
         mesh->vertex_array = -1;
     }
     if (mesh->element_buffer >= 0) {
@@ -299,7 +285,7 @@ load_texture_file(const char *dirname, const char *filename) {
 
     unsigned int texture_id;
     glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, texture_id);
 
     load_current_texture_file(path_name, GL_TEXTURE_2D);
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -0,0 +1,128 @@
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "program_cache.h"
+#include "gl_state.h"
+
+#define PROGRAM_CACHE_PATH_SIZE 64
+
+typedef struct program_cache_header {
+    char magic[8];
+    Uint64 key;
+    Uint32 binary_format;
+    Uint32 binary_length;
+} program_cache_header_t;
+
+/**
+ * FNV-1a hash of the string and its terminator, continuing from the given hash
+ */
+static Uint64
+hash_string(Uint64 hash, const char *string) {
+    do {
+        hash = (hash ^ (unsigned char) *string) * 1099511628211ull;
+    } while (*string++);
+    return hash;
+}
+
+Uint64
+get_program_key(const char *vertex_source, const char *fragment_source) {
+    Uint64 hash = 14695981039346656037ull;
+    hash = hash_string(hash, vertex_source);
+    hash = hash_string(hash, fragment_source);
+    hash = hash_string(hash, (const char *) glGetString(GL_VENDOR));
+    hash = hash_string(hash, (const char *) glGetString(GL_RENDERER));
+    return hash_string(hash, (const char *) glGetString(GL_VERSION));
+}
+
+static bool
+is_program_binary_supported() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+unsigned int
+load_program_binary(Uint64 key) {
+    if (!is_program_binary_supported()) {
+        return 0;
+    }
+    char path[PROGRAM_CACHE_PATH_SIZE];
+    sprintf(path, "%s/%016llx.bin", PROGRAM_CACHE_DIRECTORY, (unsigned long long) key);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    program_cache_header_t header;
+    void *binary = NULL;
+    if (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, PROGRAM_CACHE_MAGIC, 8) == 0
+        && header.key == key) {
+        binary = malloc(header.binary_length);
+        SDL_ALLOC_CHECK(binary)
+        if (fread(binary, 1, header.binary_length, file) != header.binary_length) {
+            free(binary);
+            binary = NULL;
+        }
+    }
+    fclose(file);
+    if (binary == NULL) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring malformed program binary %s", path);
+        return 0;
+    }
+
+    // outside of strict mode earlier errors are left in the queue
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.binary_format, binary, (GLsizei) header.binary_length);
+    free(binary);
+    // a driver update may reject the format with an error instead of a failed link status
+    GLenum error = glGetError();
+    GLint program_linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &program_linked);
+    if (error != GL_NO_ERROR || program_linked != GL_TRUE) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Program binary %s is rejected by the driver, recompiling", path);
+        gl_delete_program(program);
+        return 0;
+    }
+    return program;
+}
+
+void
+save_program_binary(unsigned int program, Uint64 key) {
+    if (!is_program_binary_supported()) {
+        return;
+    }
+    GLint binary_length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0) {
+        return;
+    }
+    program_cache_header_t header = {PROGRAM_CACHE_MAGIC};
+    header.key = key;
+    void *binary = malloc(binary_length);
+    SDL_ALLOC_CHECK(binary)
+    GLenum binary_format;
+    glGetProgramBinary(program, binary_length, NULL, &binary_format, binary);
+    GL_CHECK_ERROR;
+    header.binary_format = binary_format;
+    header.binary_length = (Uint32) binary_length;
+
+    // written aside and renamed, so a concurrent or interrupted start never reads a partial file
+    char path[PROGRAM_CACHE_PATH_SIZE];
+    char temp_path[PROGRAM_CACHE_PATH_SIZE + 16];
+    sprintf(path, "%s/%016llx.bin", PROGRAM_CACHE_DIRECTORY, (unsigned long long) header.key);
+    sprintf(temp_path, "%s.%d", path, (int) getpid());
+    mkdir(PROGRAM_CACHE_DIRECTORY, 0755);
+    FILE *file = fopen(temp_path, "wb");
+    bool saved = file != NULL && fwrite(&header, sizeof(header), 1, file) == 1
+                 && fwrite(binary, 1, binary_length, file) == binary_length;
+    if (file != NULL) {
+        saved = fclose(file) == 0 && saved;
+    }
+    free(binary);
+    if (!saved || rename(temp_path, path) != 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Could not store program binary %s, errno: %d", path, errno);
+        remove(temp_path);
+    }
+}
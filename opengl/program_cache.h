@@ -0,0 +1,29 @@
+#ifndef SDL_TEST_PROGRAM_CACHE_H
+#define SDL_TEST_PROGRAM_CACHE_H
+
+#include <stdbool.h>
+#include "gl_ext.h"
+
+/**
+ * Directory of the program binaries, relative to the working directory like the shader sources
+ */
+#define PROGRAM_CACHE_DIRECTORY "shader_cache"
+#define PROGRAM_CACHE_MAGIC "SDLTPRG1"
+
+/**
+ * Key of a program: a binary is only valid for the same sources and the same driver build
+ */
+Uint64 get_program_key(const char *vertex_source, const char *fragment_source);
+
+/**
+ * Restores the program stored for the key, 0 when it is not cached or the driver rejects the stored binary
+ */
+unsigned int load_program_binary(Uint64 key);
+
+/**
+ * Stores the binary of a program, which must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT. Failures only
+ * disable the cache entry.
+ */
+void save_program_binary(unsigned int program, Uint64 key);
+
+#endif //SDL_TEST_PROGRAM_CACHE_H
@@ -11,7 +11,7 @@ static unsigned int render_pass = 0;
 static void
 destroy_scene_screen_object_content(scene_screen_object_t *scene_screen_object) {
     if (scene_screen_object->vertex_array >= 0) {
-        glDeleteVertexArrays(1, &scene_screen_object->vertex_array);
+        gl_delete_vertex_arrays(1, &scene_screen_object->vertex_array);
         scene_screen_object->vertex_array = -1;
     }
     if (scene_screen_object->vertex_buffer >= 0) {
@@ -29,7 +29,7 @@ destroy_scene_screen_object_content(scene_screen_object_t *scene_screen_object)
 static void
 init_scene_screen_object(scene_screen_object_t *scene_screen_object) {
     glGenVertexArrays(1, &scene_screen_object->vertex_array);
-    glBindVertexArray(scene_screen_object->vertex_array);
+    gl_bind_vertex_array(scene_screen_object->vertex_array);
 
     glGenBuffers(1, &scene_screen_object->vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, scene_screen_object->vertex_buffer);
@@ -54,104 +54,167 @@ init_scene_screen_object(scene_screen_object_t *scene_screen_object) {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
 
-    glBindVertexArray(0);
+    gl_bind_vertex_array(0);
 
-    shader_t *shader = load_shader("shaders/scene_screen_vertex.glsl", "shaders/scene_screen_fragment.glsl");
+    shader_t *shader = submit_shader("shaders/scene_screen_vertex.glsl", "shaders/scene_screen_fragment.glsl");
     attach_shader(&scene_screen_object->shader, shader);
 }
 
+/**
+ * Creates the buffer for the Lights block of every program, it stays bound to LIGHTS_BLOCK_BINDING
+ */
+static void
+init_lights_buffer(lights_buffer_t *lights_buffer) {
+    for (unsigned int i = 0; i < SHADER_MAX_LIGHTS; i++) {
+        // no angle matches, so the cosines are computed on first use
+        lights_buffer->spot_angles[i][0] = NAN;
+        lights_buffer->spot_angles[i][1] = NAN;
+    }
+    glGenBuffers(1, &lights_buffer->buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, lights_buffer->buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(lights_block_t), &lights_buffer->block, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING, lights_buffer->buffer);
+    GL_CHECK_ERROR;
+}
+
+static void
+destroy_lights_buffer_content(lights_buffer_t *lights_buffer) {
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Lights buffer: %lu updates, %lu render passes with unchanged lights",
+                lights_buffer->updates, lights_buffer->updates_skipped);
+    glDeleteBuffers(1, &lights_buffer->buffer);
+    lights_buffer->buffer = 0;
+}
+
 scene_t *
 create_scene() {
     scene_t *scene = calloc(1, sizeof(scene_t));
     SDL_ALLOC_CHECK(scene);
     init_scene_screen_object(&scene->scene_screen_object);
+    init_lights_buffer(&scene->lights_buffer);
     attach_shader(&scene->selection_shader,
-                  load_shader("shaders/selection_vertex.glsl", "shaders/selection_fragment.glsl"));
+                  submit_shader("shaders/selection_vertex.glsl", "shaders/selection_fragment.glsl"));
     attach_shader(&scene->indexed_color_shader,
-                  load_shader("shaders/selection_vertex.glsl", "shaders/indexed_color_fragment.glsl"));
+                  submit_shader("shaders/selection_vertex.glsl", "shaders/indexed_color_fragment.glsl"));
+    // submitted before the cubemap is loaded, so the driver compiles it meanwhile
+    attach_shader(&scene->skybox.shader,
+                  submit_shader("shaders/skybox_vertex.glsl", "shaders/skybox_fragment.glsl"));
     return scene;
 }
 
+static camera_uniforms_t *
+get_camera_uniforms(shader_t *shader) {
+    camera_uniforms_t *uniforms = &shader->camera_uniforms;
+    if (!uniforms->resolved) {
+        uniforms->camera_position = shader_get_uniform(shader, "camera_position");
+        uniforms->resolved = true;
+    }
+    return uniforms;
+}
+
 static void
-set_up_omni_lights(scene_t *scene, shader_t *shader) {
-    unsigned int lights_number = 0;
+fill_omni_lights(scene_t *scene, lights_block_t *block) {
+    int lights_number = 0;
     omni_light_list_item_t *current_light = scene->omni_lights;
-    while (current_light != NULL) {
+    while (current_light != NULL && lights_number < SHADER_MAX_LIGHTS) {
         if (current_light->item->enabled) {
             omni_light_t *omni_light = current_light->item;
-            shader_set_vec3_array_item(shader, "omni_lights[%d].position", lights_number, omni_light->position);
-            shader_set_vec4_array_item(shader, "omni_lights[%d].light_prop.ambient", lights_number,
-                                       omni_light->light_prop.ambient);
-            shader_set_vec4_array_item(shader, "omni_lights[%d].light_prop.diffuse", lights_number,
-                                       omni_light->light_prop.diffuse);
-            shader_set_vec4_array_item(shader, "omni_lights[%d].light_prop.specular", lights_number,
-                                       omni_light->light_prop.specular);
+            omni_light_block_t *light_block = &block->omni_lights[lights_number];
+            glm_vec4_copy(omni_light->light_prop.ambient, light_block->ambient);
+            glm_vec4_copy(omni_light->light_prop.diffuse, light_block->diffuse);
+            glm_vec4_copy(omni_light->light_prop.specular, light_block->specular);
+            glm_vec3_copy(omni_light->position, light_block->position);
             lights_number++;
         }
         current_light = current_light->next;
     }
-    shader_set_int(shader, "omni_lights_number", (int) lights_number);
+    block->omni_lights_number = lights_number;
 }
 
 static void
-set_up_direct_lights(scene_t *scene, shader_t *shader) {
-    unsigned int lights_number = 0;
+fill_direct_lights(scene_t *scene, lights_block_t *block) {
+    int lights_number = 0;
     direct_light_list_item_t *current_light = scene->direct_lights;
-    while (current_light != NULL) {
+    while (current_light != NULL && lights_number < SHADER_MAX_LIGHTS) {
         if (current_light->item->enabled) {
             direct_light_t *direct_light = current_light->item;
-            shader_set_vec3_array_item(shader, "direct_lights[%d].front", lights_number, direct_light->front);
-            shader_set_vec4_array_item(shader, "direct_lights[%d].light_prop.ambient", lights_number,
-                                       direct_light->light_prop.ambient);
-            shader_set_vec4_array_item(shader, "direct_lights[%d].light_prop.diffuse", lights_number,
-                                       direct_light->light_prop.diffuse);
-            shader_set_vec4_array_item(shader, "direct_lights[%d].light_prop.specular", lights_number,
-                                       direct_light->light_prop.specular);
-
+            direct_light_block_t *light_block = &block->direct_lights[lights_number];
+            glm_vec4_copy(direct_light->light_prop.ambient, light_block->ambient);
+            glm_vec4_copy(direct_light->light_prop.diffuse, light_block->diffuse);
+            glm_vec4_copy(direct_light->light_prop.specular, light_block->specular);
+            glm_vec3_copy(direct_light->front, light_block->front);
             lights_number++;
         }
         current_light = current_light->next;
     }
-    shader_set_int(shader, "direct_lights_number", (int) lights_number);
+    block->direct_lights_number = lights_number;
 }
 
+/**
+ * The block keeps the cosines of the previous fill, they are recomputed only for a slot whose angles changed
+ */
 static void
-set_up_spot_lights(scene_t *scene, shader_t *shader) {
-    unsigned int lights_number = 0;
+fill_spot_lights(scene_t *scene, lights_block_t *block) {
+    int lights_number = 0;
     spot_light_list_item_t *current_light = scene->spot_lights;
-    while (current_light != NULL) {
+    while (current_light != NULL && lights_number < SHADER_MAX_LIGHTS) {
         if (current_light->item->enabled) {
             spot_light_t *spot_light = current_light->item;
-            shader_set_vec4_array_item(shader, "spot_lights[%d].light_prop.ambient", lights_number,
-                                       spot_light->light_prop.ambient);
-            shader_set_vec4_array_item(shader, "spot_lights[%d].light_prop.diffuse", lights_number,
-                                       spot_light->light_prop.diffuse);
-            shader_set_vec4_array_item(shader, "spot_lights[%d].light_prop.specular", lights_number,
-                                       spot_light->light_prop.specular);
-            shader_set_vec3_array_item(shader, "spot_lights[%d].position", lights_number, spot_light->position);
-            shader_set_vec3_array_item(shader, "spot_lights[%d].front", lights_number, spot_light->front);
-            shader_set_float_array_item(shader, "spot_lights[%d].angle_cos", lights_number,
-                                        (float) cos((double) spot_light->angle));
-            shader_set_float_array_item(shader, "spot_lights[%d].smooth_angle_cos", lights_number,
-                                        (float) cos((double) spot_light->angle + spot_light->smooth_angle));
+            spot_light_block_t *light_block = &block->spot_lights[lights_number];
+            glm_vec4_copy(spot_light->light_prop.ambient, light_block->ambient);
+            glm_vec4_copy(spot_light->light_prop.diffuse, light_block->diffuse);
+            glm_vec4_copy(spot_light->light_prop.specular, light_block->specular);
+            glm_vec3_copy(spot_light->position, light_block->position);
+            glm_vec3_copy(spot_light->front, light_block->front);
+            float *angles = scene->lights_buffer.spot_angles[lights_number];
+            if (angles[0] != spot_light->angle || angles[1] != spot_light->smooth_angle) {
+                angles[0] = spot_light->angle;
+                angles[1] = spot_light->smooth_angle;
+                light_block->angle_cos = (float) cos((double) spot_light->angle);
+                light_block->smooth_angle_cos = (float) cos((double) spot_light->angle + spot_light->smooth_angle);
+            }
             lights_number++;
         }
         current_light = current_light->next;
     }
-    shader_set_int(shader, "spot_lights_number", (int) lights_number);
+    block->spot_lights_number = lights_number;
+}
+
+/**
+ * Rebuilds the lights block once per render pass and uploads it only when a light changed
+ */
+static void
+update_lights_buffer(scene_t *scene) {
+    lights_buffer_t *lights_buffer = &scene->lights_buffer;
+    if (lights_buffer->render_pass == render_pass) {
+        return;
+    }
+    lights_buffer->render_pass = render_pass;
+
+    lights_block_t block;
+    memcpy(&block, &lights_buffer->block, sizeof(lights_block_t));
+    fill_omni_lights(scene, &block);
+    fill_direct_lights(scene, &block);
+    fill_spot_lights(scene, &block);
+    if (memcmp(&block, &lights_buffer->block, sizeof(lights_block_t)) == 0) {
+        lights_buffer->updates_skipped++;
+        return;
+    }
+    memcpy(&lights_buffer->block, &block, sizeof(lights_block_t));
+    glBindBuffer(GL_UNIFORM_BUFFER, lights_buffer->buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(lights_block_t), &lights_buffer->block);
+    GL_CHECK_ERROR;
+    lights_buffer->updates++;
 }
 
 static void
 set_up_light_and_camera(scene_t *scene, rendering_context_t *context) {
     shader_t *shader = context->shader;
     if (context->add_lights) {
-        set_up_omni_lights(scene, shader);
-        set_up_direct_lights(scene, shader);
-        set_up_spot_lights(scene, shader);
+        update_lights_buffer(scene);
     }
 
     if (context->add_camera_position) {
-        shader_set_vec3(shader, "camera_position", scene->camera->position);
+        shader_set_uniform_vec3(shader, get_camera_uniforms(shader)->camera_position, scene->camera->position);
     }
 }
 
@@ -168,16 +231,16 @@ render_object(scene_t *scene, scene_object_t *object, rendering_context_t *conte
 
 static void
 set_up_scene_options(scene_t *scene) {
-    glEnable(GL_DEPTH_TEST); // enables z-buffering
+    gl_enable(GL_DEPTH_TEST); // enables z-buffering
     GL_CHECK_ERROR;
 
-    glEnable(GL_BLEND);
+    gl_enable(GL_BLEND);
     GL_CHECK_ERROR;
 
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     GL_CHECK_ERROR;
 
-    glEnable(GL_CULL_FACE);
+    gl_enable(GL_CULL_FACE);
 
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     GL_CHECK_ERROR;
@@ -185,20 +248,18 @@ set_up_scene_options(scene_t *scene) {
 
 static void
 render_scene_screen(scene_t *scene) {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_STENCIL_TEST);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    gl_disable(GL_DEPTH_TEST);
+    gl_disable(GL_STENCIL_TEST);
+    gl_polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
 
     scene_screen_t *scene_screen = &scene->scene_screen;
     scene_screen_object_t *scene_screen_object = &scene->scene_screen_object;
     shader_t *shader = scene_screen_object->shader;
     shader_use(shader);
-    glBindVertexArray(scene_screen_object->vertex_array);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, scene_screen->texture);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, scene->selection_screen.texture);
+    gl_bind_vertex_array(scene_screen_object->vertex_array);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, scene_screen->texture);
+    gl_bind_texture(GL_TEXTURE1, GL_TEXTURE_2D, scene->selection_screen.texture);
     shader_set_int(shader, "effect_type", scene->effect_type);
     shader_set_float(shader, "step_x", 1.0f / (float) scene_screen->width);
     shader_set_float(shader, "step_y", 1.0f / (float) scene_screen->height);
@@ -216,7 +277,7 @@ render_scene_screen(scene_t *scene) {
  */
 static void
 render_selected_objects(scene_t *scene) {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    gl_polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
 
     rendering_context_t render_context = {scene->selection_shader, false, false, false, false, false, {0, 0, 0}, 0};
     shader_use(render_context.shader);
@@ -233,7 +294,7 @@ render_selected_objects(scene_t *scene) {
 
 static void
 render_scene_fair(scene_t *scene) {
-    glPolygonMode(GL_FRONT_AND_BACK, scene->camera->polygon_mode);
+    gl_polygon_mode(GL_FRONT_AND_BACK, scene->camera->polygon_mode);
     GL_CHECK_ERROR;
 
     scene_object_list_item_t *current_object_item = scene->objects;
@@ -253,14 +314,14 @@ render_scene_fair(scene_t *scene) {
 static void
 prepare_selection_screen(scene_t *scene) {
     update_scene_screen(&scene->selection_screen, scene->camera);
-    glBindFramebuffer(GL_FRAMEBUFFER, scene->selection_screen.render_buffer);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, scene->selection_screen.render_buffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 static void
 prepare_scene_screen(scene_t *scene) {
     update_scene_screen(&scene->scene_screen, scene->camera);
-    glBindFramebuffer(GL_FRAMEBUFFER, scene->scene_screen.render_buffer);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, scene->scene_screen.render_buffer);
     set_up_scene_options(scene);
     update_camera_views(scene->camera);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -273,18 +334,18 @@ render_skybox(scene_t *scene) {
         return;
     }
 
-    glDepthFunc(GL_LEQUAL);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    gl_depth_func(GL_LEQUAL);
+    gl_polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
     shader_use(skybox->shader);
-    glBindVertexArray(skybox->vertex_array);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->cubemap->texture);
+    gl_bind_vertex_array(skybox->vertex_array);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_CUBE_MAP, skybox->cubemap->texture);
     mat4 skybox_project_view = {0};
     compute_skybox_project_view_matrix(scene->camera, skybox_project_view);
     shader_set_mat4(skybox->shader, "project_view", skybox_project_view);
     GL_CHECK_ERROR;
     glDrawArrays(GL_TRIANGLES, 0, 36);
     GL_CHECK_ERROR;
-    glDepthFunc(GL_LESS);
+    gl_depth_func(GL_LESS);
 }
 
 void
@@ -347,7 +408,7 @@ destroy_skybox_data(scene_t *scene) {
     detach_shader(&skybox->shader);
 
     if (skybox->vertex_array >= 0) {
-        glDeleteVertexArrays(1, &skybox->vertex_array);
+        gl_delete_vertex_arrays(1, &skybox->vertex_array);
         skybox->vertex_array = -1;
     }
 
@@ -389,6 +450,7 @@ destroy_scene(scene_t **pp_scene) {
     detach_shader(&scene->indexed_color_shader);
 
     destroy_skybox_data(scene);
+    destroy_lights_buffer_content(&scene->lights_buffer);
 
     free(scene);
     *pp_scene = NULL;
@@ -445,7 +507,7 @@ static void
 render_with_indexed_colors(scene_t *scene) {
     render_pass++;
     prepare_scene_screen(scene);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    gl_polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
     rendering_context_t context = {scene->indexed_color_shader, false, false, false, false, true, {0, 0, 0}, 0};
 
     scene_object_list_item_t *current_object_item = scene->objects;
@@ -521,12 +583,11 @@ select_next_object(scene_t *scene) {
 
 static void
 init_scene_skybox(skybox_t *skybox) {
-    if (skybox->shader != NULL) {
+    if (skybox->vertex_buffer != 0) {
         return;
     }
-    attach_shader(&skybox->shader, load_shader("shaders/skybox_vertex.glsl", "shaders/skybox_fragment.glsl"));
     glGenVertexArrays(1, &skybox->vertex_array);
-    glBindVertexArray(skybox->vertex_array);
+    gl_bind_vertex_array(skybox->vertex_array);
 
     glGenBuffers(1, &skybox->vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, skybox->vertex_buffer);
@@ -580,7 +641,7 @@ init_scene_skybox(skybox_t *skybox) {
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
 
-    glBindVertexArray(0);
+    gl_bind_vertex_array(0);
 }
 
 
@@ -50,6 +50,24 @@ typedef struct skybox {
     shader_t *shader;
 } skybox_t;
 
+/**
+ * Uniform buffer with the lights of the scene, bound to LIGHTS_BLOCK_BINDING for all programs
+ */
+typedef struct lights_buffer {
+    unsigned int buffer;
+    /**
+     * content of the buffer, rebuilt once per render pass and uploaded when it differs
+     */
+    lights_block_t block;
+    /**
+     * angle and smooth angle of each spot light slot the cosines in the block were computed from
+     */
+    vec2 spot_angles[SHADER_MAX_LIGHTS];
+    unsigned int render_pass;
+    unsigned long updates;
+    unsigned long updates_skipped;
+} lights_buffer_t;
+
 typedef struct scene {
     camera_t *camera;
     scene_object_list_item_t *objects;
@@ -63,6 +81,7 @@ typedef struct scene {
     scene_screen_object_t scene_screen_object;
     effect_type_t effect_type;
     skybox_t skybox;
+    lights_buffer_t lights_buffer;
 } scene_t;
 
 scene_t *create_scene();
@@ -62,6 +62,18 @@ move_scene_object_to_vec(scene_object_t *scene_object, vec3 position) {
     move_scene_object_to(scene_object, position[0], position[1], position[2]);
 }
 
+static object_uniforms_t *
+get_object_uniforms(shader_t *shader) {
+    object_uniforms_t *uniforms = &shader->object_uniforms;
+    if (!uniforms->resolved) {
+        uniforms->model = shader_get_uniform(shader, LOC_MODEL);
+        uniforms->project_view = shader_get_uniform(shader, LOC_PROJECT_VIEW);
+        uniforms->normals_model = shader_get_uniform(shader, LOC_NORMALS_MODEL);
+        uniforms->resolved = true;
+    }
+    return uniforms;
+}
+
 void
 render_scene_object(scene_object_t *scene_object, mat4 project_view, rendering_context_t *context) {
     // model matrix
@@ -81,9 +93,10 @@ render_scene_object(scene_object_t *scene_object, mat4 project_view, rendering_c
     glm_mat4_pick3(normals_model4, normals_model3);
 
     shader_t *shader = context->shader;
-    shader_set_mat4(shader, LOC_MODEL, model);
-    shader_set_mat4(shader, LOC_PROJECT_VIEW, project_view);
-    shader_set_mat3(shader, LOC_NORMALS_MODEL, normals_model3);
+    object_uniforms_t *uniforms = get_object_uniforms(shader);
+    shader_set_uniform_mat4(shader, uniforms->model, model);
+    shader_set_uniform_mat4(shader, uniforms->project_view, project_view);
+    shader_set_uniform_mat3(shader, uniforms->normals_model, normals_model3);
 
     render_model(scene_object->model, context);
 }
@@ -5,11 +5,11 @@
 void
 destroy_scene_screen_contents(scene_screen_t *scene_screen) {
     if (scene_screen->frame_buffer >= 0) {
-        glDeleteFramebuffers(1, &scene_screen->frame_buffer);
+        gl_delete_framebuffers(1, &scene_screen->frame_buffer);
         scene_screen->frame_buffer = -1;
     }
     if (scene_screen->texture >= 0) {
-        glDeleteTextures(1, &scene_screen->texture);
+        gl_delete_textures(1, &scene_screen->texture);
         scene_screen->texture = -1;
     }
     if (scene_screen->render_buffer >= 0) {
@@ -35,18 +35,18 @@ update_scene_screen(scene_screen_t *scene_screen, camera_t *camera) {
     scene_screen->height = camera->viewport_height;
 
     glGenFramebuffers(1, &scene_screen->frame_buffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, scene_screen->frame_buffer);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, scene_screen->frame_buffer);
     GL_CHECK_ERROR;
 
     glGenTextures(1, &scene_screen->texture);
-    glBindTexture(GL_TEXTURE_2D, scene_screen->texture);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, scene_screen->texture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, (int) scene_screen->width, (int) scene_screen->height, 0, GL_RGB,
                  GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, 0);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scene_screen->texture, 0);
     GL_CHECK_ERROR;
 
@@ -61,5 +61,5 @@ update_scene_screen(scene_screen_t *scene_screen, camera_t *camera) {
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
     GL_CHECK_ERROR;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
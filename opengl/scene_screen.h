@@ -2,6 +2,7 @@
 #define SDL_TEST_SCENE_SCREEN_H
 
 #include "gl_ext.h"
+#include "gl_state.h"
 #include "camera.h"
 
 typedef struct scene_screen {
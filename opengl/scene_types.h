@@ -1,6 +1,7 @@
 #ifndef SDL_TEST_SCENE_TYPES_H
 #define SDL_TEST_SCENE_TYPES_H
 
+#include <stdint.h>
 #include "cglm_ext.h"
 #include "assimp/scene.h"
 
@@ -13,23 +14,160 @@ typedef struct material {
     float opacity;
 } material_t;
 
-typedef struct uniform_cache_item {
+/**
+ * Active uniform of a linked shader. Items of arrays are listed one by one, e.g. "textures_number[3]".
+ */
+typedef struct uniform_item {
     char *uniform_name;
+    /**
+     * GL type, e.g. GL_FLOAT_VEC3
+     */
+    unsigned int uniform_type;
+    /**
+     * number of items in the array the uniform belongs to, 1 for a plain uniform
+     */
+    int uniform_size;
     int uniform_id;
-} uniform_cache_item_t;
+    /**
+     * FNV-1a hash of the name, compared before the name when probing the index
+     */
+    unsigned int uniform_hash;
+    bool type_mismatch_reported;
+    /**
+     * shadow copy of the last value uploaded to the program, large enough for a mat4
+     */
+    bool uniform_value_set;
+    float uniform_value[16];
+} uniform_item_t;
+
+/**
+ * Index of a uniform in the shader uniforms table resolved once with shader_get_uniform(), -1 when the shader does
+ * not use it
+ */
+typedef int shader_uniform_t;
+
+/**
+ * Sizes of the light arrays and the texture slots declared in the model shaders
+ */
+#define SHADER_MAX_LIGHTS 10
+#define MIN_TEXTURE_TYPE aiTextureType_DIFFUSE
+#define MAX_TEXTURE_TYPE aiTextureType_REFLECTION
+#define MAX_TEXTURES_PER_TYPE 2
+
+/**
+ * Name and binding point of the uniform block with the scene lights in model_fragment.glsl. The structs below mirror
+ * its std140 layout: vec3 members take 16 bytes unless a float follows, structs are padded to 16 bytes.
+ */
+#define LIGHTS_BLOCK_NAME "Lights"
+#define LIGHTS_BLOCK_BINDING 0
+
+typedef struct omni_light_block {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec3 position;
+    float padding;
+} omni_light_block_t;
+
+typedef struct direct_light_block {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec3 front;
+    float padding;
+} direct_light_block_t;
+
+typedef struct spot_light_block {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec3 position;
+    float padding;
+    vec3 front;
+    float angle_cos;
+    float smooth_angle_cos;
+    float tail_padding[3];
+} spot_light_block_t;
+
+typedef struct lights_block {
+    omni_light_block_t omni_lights[SHADER_MAX_LIGHTS];
+    direct_light_block_t direct_lights[SHADER_MAX_LIGHTS];
+    spot_light_block_t spot_lights[SHADER_MAX_LIGHTS];
+    int omni_lights_number;
+    int direct_lights_number;
+    int spot_lights_number;
+    int padding;
+} lights_block_t;
+
+typedef struct camera_uniforms {
+    bool resolved;
+    shader_uniform_t camera_position;
+} camera_uniforms_t;
+
+typedef struct mesh_uniforms {
+    bool resolved;
+    shader_uniform_t textures[MAX_TEXTURE_TYPE + 1][MAX_TEXTURES_PER_TYPE];
+    shader_uniform_t textures_number[MAX_TEXTURE_TYPE + 1];
+    shader_uniform_t skybox;
+    shader_uniform_t material_ambient;
+    shader_uniform_t material_diffuse;
+    shader_uniform_t material_specular;
+    shader_uniform_t material_emissive;
+    shader_uniform_t material_shininess;
+    shader_uniform_t material_opacity;
+    shader_uniform_t index_color;
+} mesh_uniforms_t;
+
+typedef struct object_uniforms {
+    bool resolved;
+    shader_uniform_t model;
+    shader_uniform_t project_view;
+    shader_uniform_t normals_model;
+} object_uniforms_t;
 
 typedef struct shader {
     unsigned int id;
     char *vertex_shader_name;
     char *fragment_shader_name;
     unsigned int owners;
+    /**
+     * submitted with submit_shader() and not checked yet, compiled from the shader objects
+     */
+    bool pending;
+    unsigned int vertex_shader;
+    unsigned int fragment_shader;
+    uint64_t program_key;
+    struct shader *next_pending;
     /**
      * used for shader re-use with multiple scene model, to avoid useless re-configuring of global stuff, like lightning.
      */
     unsigned int render_pass;
-    unsigned int uniform_cache_items;
-    unsigned int uniform_cache_items_allocated;
-    uniform_cache_item_t *uniforms_cache;
+    /**
+     * active uniforms enumerated after linking, sorted by name
+     */
+    unsigned int uniforms_number;
+    uniform_item_t *uniforms;
+    /**
+     * open addressing table with linear probing keyed by the name hash, holding indices into uniforms or -1 for an
+     * empty slot. The capacity is a power of two at least twice the number of uniforms.
+     */
+    unsigned int uniforms_index_capacity;
+    int *uniforms_index;
+    /**
+     * setters report a type not matching the uniform declaration, enabled with debug logging
+     */
+    bool check_uniform_types;
+    /**
+     * uniform values sent to the program and values skipped as equal to the shadow copy
+     */
+    unsigned long uniform_uploads_issued;
+    unsigned long uniform_uploads_skipped;
+    /**
+     * handles of the uniforms set every frame, each group resolved on its first use by the module setting it
+     */
+    camera_uniforms_t camera_uniforms;
+    mesh_uniforms_t mesh_uniforms;
+    object_uniforms_t object_uniforms;
 } shader_t;
 
 typedef struct rendering_context {
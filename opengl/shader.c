@@ -1,5 +1,4 @@
 #include "shader.h"
-#define UNIFORM_CACHE_CAPACITY_STEP 10
 #define NAME_BUFFER_SIZE 80
 #define array_item_name(template, index) ({ \
         char name[NAME_BUFFER_SIZE]; \
@@ -8,14 +7,52 @@
     })
 
 
+static Uint64 shaders_setup_ticks = 0;
+static unsigned int shaders_loaded = 0;
+static unsigned int shaders_restored = 0;
+
+/**
+ * Submitted shaders whose status is not checked yet, linked through next_pending
+ */
+static shader_t *pending_shaders = NULL;
+static bool parallel_compile_initialized = false;
+static bool parallel_compile_supported = false;
+
+typedef void (*max_shader_compiler_threads_t)(GLuint count);
+
+static void
+init_parallel_compile() {
+    if (parallel_compile_initialized) {
+        return;
+    }
+    parallel_compile_initialized = true;
+    const char *function_name = NULL;
+    if (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile")) {
+        function_name = "glMaxShaderCompilerThreadsKHR";
+    } else if (SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile")) {
+        function_name = "glMaxShaderCompilerThreadsARB";
+    }
+    if (function_name == NULL) {
+        return;
+    }
+    max_shader_compiler_threads_t max_shader_compiler_threads = SDL_GL_GetProcAddress(function_name);
+    if (max_shader_compiler_threads != NULL) {
+        // let the driver pick the number of threads
+        max_shader_compiler_threads(0xFFFFFFFF);
+    }
+    parallel_compile_supported = true;
+}
+
 static unsigned int
-load_shader_file(unsigned int shader_type, const char *file_name) {
+load_shader_file(unsigned int shader_type, const char *src) {
     unsigned int id = glCreateShader(shader_type);
-    const char *src = load_text_file(file_name);
     glShaderSource(id, 1, &src, NULL);
     glCompileShader(id);
-    free((void *) src);
+    return id;
+}
 
+static void
+check_shader_file(unsigned int id, const char *file_name) {
     int result;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
@@ -28,18 +65,160 @@ load_shader_file(unsigned int shader_type, const char *file_name) {
         SDL_Die("Failed to compile shader %s: %s", file_name, msg);
         exit(1);
     }
-    return id;
 }
 
-shader_t *
-load_shader(const char *vertex_shader_name, const char *fragment_shader_name) {
-    unsigned int program = glCreateProgram();
-    unsigned vertex_shader = load_shader_file(GL_VERTEX_SHADER, vertex_shader_name);
-    unsigned fragment_shader = load_shader_file(GL_FRAGMENT_SHADER, fragment_shader_name);
+static int
+compare_uniform_items(const void *a, const void *b) {
+    return strcmp(((const uniform_item_t *) a)->uniform_name, ((const uniform_item_t *) b)->uniform_name);
+}
+
+/**
+ * FNV-1a hash of the name
+ */
+static unsigned int
+hash_uniform_name(const char *name) {
+    unsigned int hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ (unsigned char) *name) * 16777619u;
+    }
+    return hash;
+}
+
+static void
+add_uniform_item(shader_t *shader, const char *name, GLenum type, GLint size) {
+    uniform_item_t *item = &shader->uniforms[shader->uniforms_number++];
+    item->uniform_name = malloc(strlen(name) + 1);
+    SDL_ALLOC_CHECK(item->uniform_name)
+    strcpy(item->uniform_name, name);
+    item->uniform_hash = hash_uniform_name(name);
+    item->uniform_type = type;
+    item->uniform_size = size;
+    item->uniform_id = glGetUniformLocation(shader->id, name);
+}
+
+/**
+ * Builds the hash index over the sorted uniforms table, which stays the storage the handles point into
+ */
+static void
+index_shader_uniforms(shader_t *shader) {
+    unsigned int capacity = 16;
+    while (capacity < shader->uniforms_number * 2) {
+        capacity *= 2;
+    }
+    shader->uniforms_index_capacity = capacity;
+    shader->uniforms_index = malloc(capacity * sizeof(int));
+    SDL_ALLOC_CHECK(shader->uniforms_index)
+    memset(shader->uniforms_index, -1, capacity * sizeof(int));
+    for (unsigned int i = 0; i < shader->uniforms_number; i++) {
+        unsigned int slot = shader->uniforms[i].uniform_hash & (capacity - 1);
+        while (shader->uniforms_index[slot] >= 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        shader->uniforms_index[slot] = (int) i;
+    }
+}
+
+/**
+ * Fills the uniforms table from the active uniforms of the linked program, skipping the members of uniform blocks.
+ * An array is reported once as "name[0]", its items are added one by one.
+ */
+static void
+load_shader_uniforms(shader_t *shader) {
+    GLint active_uniforms = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(shader->id, GL_ACTIVE_UNIFORMS, &active_uniforms);
+    glGetProgramiv(shader->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+    if (active_uniforms == 0) {
+        return;
+    }
 
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-    glLinkProgram(program);
+    GLuint *indices = malloc(active_uniforms * sizeof(GLuint));
+    SDL_ALLOC_CHECK(indices)
+    GLint *sizes = malloc(active_uniforms * sizeof(GLint));
+    SDL_ALLOC_CHECK(sizes)
+    GLint *block_indices = malloc(active_uniforms * sizeof(GLint));
+    SDL_ALLOC_CHECK(block_indices)
+    for (GLint i = 0; i < active_uniforms; i++) {
+        indices[i] = i;
+    }
+    glGetActiveUniformsiv(shader->id, active_uniforms, indices, GL_UNIFORM_SIZE, sizes);
+    glGetActiveUniformsiv(shader->id, active_uniforms, indices, GL_UNIFORM_BLOCK_INDEX, block_indices);
+    unsigned int items_number = 0;
+    for (GLint i = 0; i < active_uniforms; i++) {
+        if (block_indices[i] < 0) {
+            items_number += sizes[i];
+        }
+    }
+    shader->uniforms = calloc(items_number, sizeof(uniform_item_t));
+    SDL_ALLOC_CHECK(shader->uniforms)
+
+    char *name = alloca(max_name_length + NAME_BUFFER_SIZE);
+    for (GLint i = 0; i < active_uniforms; i++) {
+        if (block_indices[i] >= 0) {
+            continue;
+        }
+        GLint size;
+        GLenum type;
+        GLsizei length;
+        glGetActiveUniform(shader->id, i, max_name_length, &length, &size, &type, name);
+        if (size > 1 && length > 3 && strcmp(name + length - 3, "[0]") == 0) {
+            for (GLint item = 0; item < size; item++) {
+                sprintf(name + length - 3, "[%d]", item);
+                add_uniform_item(shader, name, type, size);
+            }
+        } else {
+            add_uniform_item(shader, name, type, size);
+        }
+    }
+    GL_CHECK_ERROR;
+    qsort(shader->uniforms, shader->uniforms_number, sizeof(uniform_item_t), compare_uniform_items);
+    index_shader_uniforms(shader);
+
+    free(block_indices);
+    free(sizes);
+    free(indices);
+}
+
+/**
+ * Points the Lights block of the program at the binding of the buffer shared by the scene, once after linking
+ */
+static void
+bind_lights_block(shader_t *shader) {
+    GLuint block_index = glGetUniformBlockIndex(shader->id, LIGHTS_BLOCK_NAME);
+    if (block_index == GL_INVALID_INDEX) {
+        return;
+    }
+    GLint block_size = 0;
+    glGetActiveUniformBlockiv(shader->id, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+    if ((size_t) block_size > sizeof(lights_block_t)) {
+        SDL_Die("%s block of %s takes %d bytes, lights_block_t has %zu", LIGHTS_BLOCK_NAME,
+                shader->fragment_shader_name, block_size, sizeof(lights_block_t));
+    }
+    glUniformBlockBinding(shader->id, block_index, LIGHTS_BLOCK_BINDING);
+    GL_CHECK_ERROR;
+}
+
+static void
+remove_pending_shader(shader_t *shader) {
+    shader_t **link = &pending_shaders;
+    while (*link != shader) {
+        link = &(*link)->next_pending;
+    }
+    *link = shader->next_pending;
+    shader->next_pending = NULL;
+    shader->pending = false;
+}
+
+/**
+ * Checks the compile and link status of a submitted program, waiting for the driver if it is not done yet
+ */
+static void
+finish_shader(shader_t *shader) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    remove_pending_shader(shader);
+    unsigned int program = shader->id;
+    check_shader_file(shader->vertex_shader, shader->vertex_shader_name);
+    check_shader_file(shader->fragment_shader, shader->fragment_shader_name);
 
     GLint program_linked;
     glGetProgramiv(program, GL_LINK_STATUS, &program_linked);
@@ -47,7 +226,7 @@ load_shader(const char *vertex_shader_name, const char *fragment_shader_name) {
         GLsizei log_length = 0;
         GLchar message[1024];
         glGetProgramInfoLog(program, 1024, &log_length, message);
-        glDeleteProgram(program);
+        gl_delete_program(program);
         SDL_Die("Error linking program: %s", message);
         exit(1);
     }
@@ -58,18 +237,43 @@ load_shader(const char *vertex_shader_name, const char *fragment_shader_name) {
         GLsizei log_length = 0;
         GLchar message[1024];
         glGetProgramInfoLog(program, 1024, &log_length, message);
-        glDeleteProgram(program);
+        gl_delete_program(program);
         SDL_Die("Error validating program: %s", message);
     }
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+    glDetachShader(program, shader->vertex_shader);
+    glDetachShader(program, shader->fragment_shader);
+    glDeleteShader(shader->vertex_shader);
+    glDeleteShader(shader->fragment_shader);
+    shader->vertex_shader = 0;
+    shader->fragment_shader = 0;
+    save_program_binary(program, shader->program_key);
+    load_shader_uniforms(shader);
+    bind_lights_block(shader);
+
+    Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    shaders_setup_ticks += ticks;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Compiled shader from: %s and %s, waited %.2f ms",
+                shader->vertex_shader_name, shader->fragment_shader_name,
+                (double) ticks * 1000.0 / (double) SDL_GetPerformanceFrequency());
+}
 
-    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Created shader from: %s and %s", vertex_shader_name,
-                fragment_shader_name);
+/**
+ * Status queries block until the driver is done, so they are deferred until the program is needed
+ */
+static inline void
+ensure_shader_finished(shader_t *shader) {
+    if (shader->pending) {
+        finish_shader(shader);
+    }
+}
 
+shader_t *
+submit_shader(const char *vertex_shader_name, const char *fragment_shader_name) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    init_parallel_compile();
     shader_t *shader = calloc(1, sizeof(shader_t));
     SDL_ALLOC_CHECK(shader)
-    shader->id = program;
+    shader->check_uniform_types = SDL_DEBUG_ENABLED;
 
     shader->vertex_shader_name = malloc(strlen(vertex_shader_name) + 1);
     SDL_ALLOC_CHECK(shader->vertex_shader_name)
@@ -79,11 +283,83 @@ load_shader(const char *vertex_shader_name, const char *fragment_shader_name) {
     SDL_ALLOC_CHECK(shader->fragment_shader_name)
     strcpy(shader->fragment_shader_name, fragment_shader_name);
 
+    char *vertex_source = load_text_file(vertex_shader_name);
+    char *fragment_source = load_text_file(fragment_shader_name);
+    shader->program_key = get_program_key(vertex_source, fragment_source);
+    // a restored binary was validated when it was compiled
+    shader->id = load_program_binary(shader->program_key);
+    bool restored = shader->id != 0;
+    if (restored) {
+        load_shader_uniforms(shader);
+        bind_lights_block(shader);
+    } else {
+        shader->id = glCreateProgram();
+        shader->vertex_shader = load_shader_file(GL_VERTEX_SHADER, vertex_source);
+        shader->fragment_shader = load_shader_file(GL_FRAGMENT_SHADER, fragment_source);
+        glAttachShader(shader->id, shader->vertex_shader);
+        glAttachShader(shader->id, shader->fragment_shader);
+        glProgramParameteri(shader->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(shader->id);
+        shader->pending = true;
+        shader->next_pending = pending_shaders;
+        pending_shaders = shader;
+    }
+    free(vertex_source);
+    free(fragment_source);
+
+    Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    shaders_setup_ticks += ticks;
+    shaders_loaded++;
+    shaders_restored += restored;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Created shader from: %s and %s, %s in %.2f ms", vertex_shader_name,
+                fragment_shader_name, restored ? "restored from the program binary cache" : "submitted",
+                (double) ticks * 1000.0 / (double) SDL_GetPerformanceFrequency());
     return shader;
 }
 
+void
+collect_shaders() {
+    while (pending_shaders != NULL) {
+        // with parallel compilation, programs the driver is done with are taken first
+        shader_t *shader = pending_shaders;
+        if (parallel_compile_supported) {
+            for (shader_t *current = pending_shaders; current != NULL; current = current->next_pending) {
+                GLint completed = GL_FALSE;
+                glGetProgramiv(current->id, GL_COMPLETION_STATUS_KHR, &completed);
+                if (completed) {
+                    shader = current;
+                    break;
+                }
+            }
+        }
+        finish_shader(shader);
+    }
+}
+
+shader_t *
+load_shader(const char *vertex_shader_name, const char *fragment_shader_name) {
+    shader_t *shader = submit_shader(vertex_shader_name, fragment_shader_name);
+    ensure_shader_finished(shader);
+    return shader;
+}
+
+void
+log_shaders_setup_time() {
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Shader setup: %u programs, %u restored from the cache, %.2f ms",
+                shaders_loaded, shaders_restored,
+                (double) shaders_setup_ticks * 1000.0 / (double) SDL_GetPerformanceFrequency());
+}
+
 static void
 destroy_shader(shader_t *shader) {
+    if (shader->pending) {
+        remove_pending_shader(shader);
+        glDeleteShader(shader->vertex_shader);
+        glDeleteShader(shader->fragment_shader);
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Uniform uploads of shader built from %s and %s: %lu issued, %lu skipped",
+                shader->vertex_shader_name, shader->fragment_shader_name, shader->uniform_uploads_issued,
+                shader->uniform_uploads_skipped);
     if (shader->vertex_shader_name) {
         free(shader->vertex_shader_name);
         shader->vertex_shader_name = NULL;
@@ -93,92 +369,181 @@ destroy_shader(shader_t *shader) {
         shader->fragment_shader_name = NULL;
     }
     if (shader->id >= 0) {
-        glDeleteProgram(shader->id);
+        gl_delete_program(shader->id);
     }
 
-    for (int i = 0; i < shader->uniform_cache_items; i++) {
-        free(shader->uniforms_cache[i].uniform_name);
-        shader->uniforms_cache[i].uniform_name = NULL;
-    }
-    if (shader->uniform_cache_items_allocated > 0) {
-        free(shader->uniforms_cache);
-        shader->uniforms_cache = NULL;
+    for (unsigned int i = 0; i < shader->uniforms_number; i++) {
+        free(shader->uniforms[i].uniform_name);
     }
+    free(shader->uniforms);
+    shader->uniforms = NULL;
+    free(shader->uniforms_index);
+    shader->uniforms_index = NULL;
 
     free(shader);
 }
 
 void
 shader_use(shader_t *shader) {
-    glUseProgram(shader->id);
+    ensure_shader_finished(shader);
+    gl_use_program(shader->id);
 }
 
-static GLint
-get_cached_uniform_name(shader_t *shader, const char *name) {
-    for (int i = 0; i < shader->uniform_cache_items; i++) {
-        if (strcmp(shader->uniforms_cache[i].uniform_name, name) == 0) {
-            return shader->uniforms_cache[i].uniform_id;
+static shader_uniform_t
+find_uniform(shader_t *shader, const char *name) {
+    ensure_shader_finished(shader);
+    if (shader->uniforms_index == NULL) {
+        return -1;
+    }
+    unsigned int hash = hash_uniform_name(name);
+    unsigned int mask = shader->uniforms_index_capacity - 1;
+    for (unsigned int slot = hash & mask;; slot = (slot + 1) & mask) {
+        int index = shader->uniforms_index[slot];
+        if (index < 0) {
+            return -1;
+        }
+        uniform_item_t *item = &shader->uniforms[index];
+        if (item->uniform_hash == hash && strcmp(item->uniform_name, name) == 0) {
+            return index;
         }
     }
-    return -1;
 }
 
-static GLint
-cache_uniform_name(shader_t *shader, const char *name, GLint uniform_id) {
-    if (0 == shader->uniform_cache_items_allocated) {
-        shader->uniform_cache_items_allocated = UNIFORM_CACHE_CAPACITY_STEP;
-        shader->uniforms_cache = calloc(shader->uniform_cache_items_allocated, sizeof(uniform_cache_item_t));
-    } else if (shader->uniform_cache_items == shader->uniform_cache_items_allocated) {
-        shader->uniform_cache_items_allocated += UNIFORM_CACHE_CAPACITY_STEP;
-        shader->uniforms_cache = reallocarray(shader->uniforms_cache, shader->uniform_cache_items_allocated,
-                                              sizeof(uniform_cache_item_t));
-        SDL_ALLOC_CHECK(shader->uniforms_cache)
+shader_uniform_t
+shader_get_uniform(shader_t *shader, const char *name) {
+    return find_uniform(shader, name);
+}
+
+shader_uniform_t
+shader_get_uniform_array_item(shader_t *shader, const char *name_template, unsigned int index) {
+    char name[NAME_BUFFER_SIZE];
+    sprintf(name, name_template, index);
+    return find_uniform(shader, name);
+}
+
+static bool
+is_uniform_type(GLenum uniform_type, GLenum setter_type) {
+    if (uniform_type == setter_type) {
+        return true;
+    }
+    if (setter_type != GL_INT) {
+        return false;
+    }
+    switch (uniform_type) {
+        case GL_BOOL:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Item of the uniform, NULL when it is not used by the shader
+ */
+static uniform_item_t *
+get_uniform_item(shader_t *shader, shader_uniform_t uniform, GLenum setter_type) {
+    if (uniform < 0) {
+        return NULL;
     }
+    uniform_item_t *item = &shader->uniforms[uniform];
+    if (shader->check_uniform_types && !item->type_mismatch_reported
+        && !is_uniform_type(item->uniform_type, setter_type)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Uniform %s of type 0x%x is set as 0x%x in shader built from %s and %s",
+                    item->uniform_name, item->uniform_type, setter_type, shader->vertex_shader_name,
+                    shader->fragment_shader_name);
+        item->type_mismatch_reported = true;
+    }
+    return item;
+}
 
-    shader->uniforms_cache[shader->uniform_cache_items].uniform_name = malloc(strlen(name) + 1);
-    strcpy(shader->uniforms_cache[shader->uniform_cache_items].uniform_name, name);
-    shader->uniforms_cache[shader->uniform_cache_items].uniform_id = uniform_id;
+/**
+ * Updates the shadow copy of the uniform, false when the program already holds the value and the upload is skipped
+ */
+static bool
+update_uniform_value(shader_t *shader, uniform_item_t *item, const void *value, size_t size) {
+    if (item->uniform_value_set && memcmp(item->uniform_value, value, size) == 0) {
+        shader->uniform_uploads_skipped++;
+        return false;
+    }
+    memcpy(item->uniform_value, value, size);
+    item->uniform_value_set = true;
+    shader->uniform_uploads_issued++;
+    return true;
+}
 
-    shader->uniform_cache_items++;
+void
+shader_set_uniform_mat4(shader_t *shader, shader_uniform_t uniform, mat4 value) {
+    uniform_item_t *item = get_uniform_item(shader, uniform, GL_FLOAT_MAT4);
+    if (item != NULL && update_uniform_value(shader, item, value, sizeof(mat4))) {
+        glUniformMatrix4fv(item->uniform_id, 1, GL_FALSE, (GLfloat *) value);
+        GL_CHECK_ERROR;
+    }
+}
 
-    return uniform_id;
+void
+shader_set_uniform_mat3(shader_t *shader, shader_uniform_t uniform, mat3 value) {
+    uniform_item_t *item = get_uniform_item(shader, uniform, GL_FLOAT_MAT3);
+    if (item != NULL && update_uniform_value(shader, item, value, sizeof(mat3))) {
+        glUniformMatrix3fv(item->uniform_id, 1, GL_FALSE, (GLfloat *) value);
+        GL_CHECK_ERROR;
+    }
 }
 
-static GLint
-uniform_name(shader_t *shader, const char *name) {
-    GLint cached_result = get_cached_uniform_name(shader, name);
-    if (cached_result >= 0) {
-        return cached_result;
+void
+shader_set_uniform_vec3(shader_t *shader, shader_uniform_t uniform, vec3 value) {
+    uniform_item_t *item = get_uniform_item(shader, uniform, GL_FLOAT_VEC3);
+    if (item != NULL && update_uniform_value(shader, item, value, sizeof(vec3))) {
+        glUniform3f(item->uniform_id, value[0], value[1], value[2]);
+        GL_CHECK_ERROR;
     }
-    GLint unform_id = glGetUniformLocation(shader->id, name);
-    if (unform_id < 0 && SDL_DEBUG_ENABLED) {
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                     "Could not find the uniform %s in shader built from %s and %s",
-                     name,
-                     shader->vertex_shader_name,
-                     shader->fragment_shader_name);
+}
+
+void
+shader_set_uniform_vec4(shader_t *shader, shader_uniform_t uniform, vec4 value) {
+    uniform_item_t *item = get_uniform_item(shader, uniform, GL_FLOAT_VEC4);
+    if (item != NULL && update_uniform_value(shader, item, value, sizeof(vec4))) {
+        glUniform4f(item->uniform_id, value[0], value[1], value[2], value[3]);
+        GL_CHECK_ERROR;
     }
-    GL_CHECK_ERROR;
+}
 
-    return cache_uniform_name(shader, name, unform_id);
+void
+shader_set_uniform_float(shader_t *shader, shader_uniform_t uniform, float value) {
+    uniform_item_t *item = get_uniform_item(shader, uniform, GL_FLOAT);
+    if (item != NULL && update_uniform_value(shader, item, &value, sizeof(float))) {
+        glUniform1f(item->uniform_id, value);
+        GL_CHECK_ERROR;
+    }
+}
+
+void
+shader_set_uniform_int(shader_t *shader, shader_uniform_t uniform, int value) {
+    uniform_item_t *item = get_uniform_item(shader, uniform, GL_INT);
+    if (item != NULL && update_uniform_value(shader, item, &value, sizeof(int))) {
+        glUniform1i(item->uniform_id, value);
+        GL_CHECK_ERROR;
+    }
 }
 
 void
 shader_set_mat4(shader_t *shader, const char *name, mat4 value) {
-    glUniformMatrix4fv(uniform_name(shader, name), 1, GL_FALSE, (GLfloat *) value);
-    GL_CHECK_ERROR;
+    shader_set_uniform_mat4(shader, find_uniform(shader, name), value);
 }
 
 void
 shader_set_mat3(shader_t *shader, const char *name, mat3 value) {
-    glUniformMatrix3fv(uniform_name(shader, name), 1, GL_FALSE, (GLfloat *) value);
-    GL_CHECK_ERROR;
+    shader_set_uniform_mat3(shader, find_uniform(shader, name), value);
 }
 
 void
 shader_set_vec3(shader_t *shader, const char *name, vec3 value) {
-    glUniform3f(uniform_name(shader, name), value[0], value[1], value[2]);
-    GL_CHECK_ERROR;
+    shader_set_uniform_vec3(shader, find_uniform(shader, name), value);
 }
 
 void
@@ -188,8 +553,7 @@ shader_set_vec3_array_item(shader_t *shader, const char *name_template, unsigned
 
 void
 shader_set_vec4(shader_t *shader, const char *name, vec4 value) {
-    glUniform4f(uniform_name(shader, name), value[0], value[1], value[2], value[3]);
-    GL_CHECK_ERROR;
+    shader_set_uniform_vec4(shader, find_uniform(shader, name), value);
 }
 
 void
@@ -199,8 +563,7 @@ shader_set_vec4_array_item(shader_t *shader, const char *name_template, unsigned
 
 void
 shader_set_float(shader_t *shader, const char *name, float value) {
-    glUniform1f(uniform_name(shader, name), value);
-    GL_CHECK_ERROR;
+    shader_set_uniform_float(shader, find_uniform(shader, name), value);
 }
 
 void
@@ -210,8 +573,7 @@ shader_set_float_array_item(shader_t *shader, const char *name_template, unsigne
 
 void
 shader_set_int(shader_t *shader, const char *name, int value) {
-    glUniform1i(uniform_name(shader, name), value);
-    GL_CHECK_ERROR;
+    shader_set_uniform_int(shader, find_uniform(shader, name), value);
 }
 
 void
@@ -219,6 +581,142 @@ shader_set_int_array_item(shader_t *shader, const char *name_template, unsigned
     shader_set_int(shader, array_item_name(name_template, index), value);
 }
 
+/**
+ * Names set for a frame of the scene with lights of each type set as uniforms of every program, the way lights were
+ * set before the Lights block, and the names set by render_mesh()
+ */
+static unsigned int
+get_benchmark_uniform_names(char names[][NAME_BUFFER_SIZE], unsigned int lights) {
+    static const char *TEMPLATES[] = {
+            "omni_lights[%d].position", "omni_lights[%d].light_prop.ambient", "omni_lights[%d].light_prop.diffuse",
+            "omni_lights[%d].light_prop.specular", "direct_lights[%d].front", "direct_lights[%d].light_prop.ambient",
+            "direct_lights[%d].light_prop.diffuse", "direct_lights[%d].light_prop.specular",
+            "spot_lights[%d].light_prop.ambient", "spot_lights[%d].light_prop.diffuse",
+            "spot_lights[%d].light_prop.specular", "spot_lights[%d].position", "spot_lights[%d].front",
+            "spot_lights[%d].angle_cos", "spot_lights[%d].smooth_angle_cos", "textures_number[%d]"
+    };
+    static const char *NAMES[] = {
+            "omni_lights_number", "direct_lights_number", "spot_lights_number", "camera_position", "material.ambient",
+            "material.diffuse", "material.specular", "material.emissive", "material.shininess", "material.opacity",
+            LOC_MODEL, LOC_PROJECT_VIEW, LOC_NORMALS_MODEL
+    };
+    unsigned int count = 0;
+    for (int i = 0; i < SDL_arraysize(TEMPLATES); i++) {
+        for (unsigned int light = 0; light < lights; light++) {
+            sprintf(names[count++], TEMPLATES[i], light);
+        }
+    }
+    for (int i = 0; i < SDL_arraysize(NAMES); i++) {
+        strcpy(names[count++], NAMES[i]);
+    }
+    return count;
+}
+
+void
+run_uniform_lookup_benchmark(unsigned int frames) {
+    const unsigned int lights = 4;
+    char names[16 * 4 + 13][NAME_BUFFER_SIZE];
+    unsigned int names_number = get_benchmark_uniform_names(names, lights);
+
+    // the table in declaration order scanned linearly, as the reference
+    shader_t *shader = calloc(1, sizeof(shader_t));
+    SDL_ALLOC_CHECK(shader)
+    uniform_item_t *linear_table = calloc(names_number, sizeof(uniform_item_t));
+    SDL_ALLOC_CHECK(linear_table)
+    shader->uniforms = calloc(names_number, sizeof(uniform_item_t));
+    SDL_ALLOC_CHECK(shader->uniforms)
+    for (unsigned int i = 0; i < names_number; i++) {
+        linear_table[i].uniform_name = names[i];
+        linear_table[i].uniform_hash = hash_uniform_name(names[i]);
+        linear_table[i].uniform_id = (int) i;
+    }
+    memcpy(shader->uniforms, linear_table, names_number * sizeof(uniform_item_t));
+    shader->uniforms_number = names_number;
+    qsort(shader->uniforms, shader->uniforms_number, sizeof(uniform_item_t), compare_uniform_items);
+    index_shader_uniforms(shader);
+
+    Uint64 linear_sum = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (unsigned int frame = 0; frame < frames; frame++) {
+        for (unsigned int i = 0; i < names_number; i++) {
+            for (unsigned int j = 0; j < names_number; j++) {
+                if (strcmp(linear_table[j].uniform_name, names[i]) == 0) {
+                    linear_sum += linear_table[j].uniform_id;
+                    break;
+                }
+            }
+        }
+    }
+    Uint64 linear_ticks = SDL_GetPerformanceCounter() - start;
+
+    Uint64 hash_sum = 0;
+    start = SDL_GetPerformanceCounter();
+    for (unsigned int frame = 0; frame < frames; frame++) {
+        for (unsigned int i = 0; i < names_number; i++) {
+            hash_sum += shader->uniforms[find_uniform(shader, names[i])].uniform_id;
+        }
+    }
+    Uint64 hash_ticks = SDL_GetPerformanceCounter() - start;
+
+    double lookups = (double) frames * names_number;
+    double frequency = (double) SDL_GetPerformanceFrequency();
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Uniform lookup of %u names: linear %.1f ns/lookup, hash %.1f ns/lookup (%.1fx)%s", names_number,
+                (double) linear_ticks * 1e9 / frequency / lookups, (double) hash_ticks * 1e9 / frequency / lookups,
+                (double) linear_ticks / (double) hash_ticks, linear_sum == hash_sum ? "" : ", RESULTS DIFFER");
+
+    free(shader->uniforms_index);
+    free(shader->uniforms);
+    free(shader);
+    free(linear_table);
+}
+
+void
+run_gl_error_benchmark(unsigned int frames) {
+    const unsigned int uploads_per_frame = 256;
+    shader_t *shader = NULL;
+    attach_shader(&shader, load_shader("shaders/scene_screen_vertex.glsl", "shaders/scene_screen_fragment.glsl"));
+    shader_uniform_t uniforms[] = {
+            shader_get_uniform(shader, "step_x"), shader_get_uniform(shader, "step_y"),
+            shader_get_uniform(shader, "time")
+    };
+    unsigned int vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+    gl_bind_vertex_array(vertex_array);
+    shader_use(shader);
+
+    // modes alternate frame by frame after a warm-up, the submission is timed without the wait for the GPU
+    bool strict_errors = gl_strict_errors;
+    Uint64 ticks[2] = {0, 0};
+    for (unsigned int frame = 0; frame < frames * 2 + 100; frame++) {
+        int strict = (int) (frame & 1);
+        gl_strict_errors = strict;
+        Uint64 start = SDL_GetPerformanceCounter();
+        // values change every upload, so none is skipped as redundant
+        for (unsigned int i = 0; i < uploads_per_frame; i++) {
+            float value = (float) (frame * uploads_per_frame + i);
+            shader_set_uniform_float(shader, uniforms[i % SDL_arraysize(uniforms)], value);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        GL_CHECK_ERROR;
+        if (frame >= 100) {
+            ticks[strict] += SDL_GetPerformanceCounter() - start;
+        }
+        glFinish();
+    }
+    gl_strict_errors = strict_errors;
+
+    double frequency = (double) SDL_GetPerformanceFrequency();
+    double channel_us = (double) ticks[0] * 1e6 / frequency / frames;
+    double strict_us = (double) ticks[1] * 1e6 / frequency / frames;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "GL error checks for %u uploads and a draw per frame: strict %.1f us/frame, "
+                "debug output %.1f us/frame, %.1f us/frame saved",
+                uploads_per_frame, strict_us, channel_us, strict_us - channel_us);
+
+    gl_delete_vertex_arrays(1, &vertex_array);
+    detach_shader(&shader);
+}
 
 void
 attach_shader(shader_t **target, shader_t *shader) {
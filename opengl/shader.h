@@ -8,18 +8,65 @@
 #include "scene_types.h"
 #include "sdl_ext.h"
 #include "gl_ext.h"
+#include "gl_state.h"
 #include "file_util.h"
+#include "program_cache.h"
 #include "cglm_ext.h"
 #include "scene_object.h"
 
+/**
+ * Starts compiling and linking the program, or restores its binary from PROGRAM_CACHE_DIRECTORY when the sources
+ * and the driver did not change. Status checks are deferred until the shader is used or collect_shaders() is called,
+ * so the driver compiles while the caller does other work.
+ */
+shader_t *submit_shader(const char *vertex_shader_name, const char *fragment_shader_name);
+
+/**
+ * Checks all submitted shaders, taking first the programs the driver is done with when it supports
+ * GL_KHR_parallel_shader_compile
+ */
+void collect_shaders();
+
+/**
+ * Same as submit_shader() with the status checked immediately
+ */
 shader_t *load_shader(const char *vertex_shader_name, const char *fragment_shader_name);
 
+/**
+ * Logs the time spent in load_shader() so far, to compare a cold start with a warm program binary cache
+ */
+void log_shaders_setup_time();
+
 void attach_shader(shader_t **target, shader_t *shader);
 
 void detach_shader(shader_t **shader_pointer);
 
 void shader_use(shader_t *shader);
 
+/**
+ * Resolves a uniform once in the table of active uniforms enumerated by load_shader(), to be set with the
+ * shader_set_uniform_*() functions without any string work. Uniforms the shader does not use resolve to -1, which
+ * the setters ignore. With debug logging the setters warn once about a type not matching the declaration.
+ */
+shader_uniform_t shader_get_uniform(shader_t *shader, const char *name);
+
+/**
+ * Same as shader_get_uniform() for an array item or its struct member, e.g. "omni_lights[%u].position"
+ */
+shader_uniform_t shader_get_uniform_array_item(shader_t *shader, const char *name_template, unsigned int index);
+
+void shader_set_uniform_mat4(shader_t *shader, shader_uniform_t uniform, mat4 value);
+
+void shader_set_uniform_mat3(shader_t *shader, shader_uniform_t uniform, mat3 value);
+
+void shader_set_uniform_vec3(shader_t *shader, shader_uniform_t uniform, vec3 value);
+
+void shader_set_uniform_vec4(shader_t *shader, shader_uniform_t uniform, vec4 value);
+
+void shader_set_uniform_float(shader_t *shader, shader_uniform_t uniform, float value);
+
+void shader_set_uniform_int(shader_t *shader, shader_uniform_t uniform, int value);
+
 void shader_set_mat4(shader_t *shader, const char *name, mat4 value);
 
 void shader_set_mat3(shader_t *shader, const char *name, mat3 value);
@@ -40,4 +87,16 @@ void shader_set_int(shader_t *shader, const char *name, int value);
 
 void shader_set_int_array_item(shader_t *shader, const char *name_template, unsigned int index, int value);
 
+/**
+ * Measures uniform lookups by name of the names set for a scene frame, hash index over the sorted table against a
+ * linear scan. Needs no OpenGL context.
+ */
+void run_uniform_lookup_benchmark(unsigned int frames);
+
+/**
+ * Measures the CPU time of uniform uploads and a draw per frame with strict glGetError() checks against errors
+ * reported through debug output. Needs an OpenGL context.
+ */
+void run_gl_error_benchmark(unsigned int frames);
+
 #endif //SDL_TEST_SHADER_H
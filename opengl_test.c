@@ -19,6 +19,8 @@ static int window_height = 1280 / 16 * 9;
 static const Uint32 FPS = 30;
 static const Uint32 FPS_SIZE_MS = 1000 / FPS;
 
+static const Uint32 GL_STATE_STATS_FRAMES = 5 * 30;
+
 static scene_t *scene;
 
 static spot_light_t *flying_spot_light;
@@ -34,6 +36,7 @@ static scene_object_t *cubes[4];
 
 static SDL_Window *window = NULL;
 static SDL_GLContext context = NULL;
+static bool strict_gl_errors = false;
 
 static bool initialize_app();
 
@@ -43,11 +46,21 @@ static void event_loop();
 
 static void shutdown_app();
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench-uniforms") == 0) {
+        run_uniform_lookup_benchmark(10000);
+        return 0;
+    }
+    bool bench_gl_errors = argc > 1 && strcmp(argv[1], "--bench-gl-errors") == 0;
+    strict_gl_errors = argc > 1 && strcmp(argv[1], "--strict-gl") == 0;
     atexit(shutdown_app);
     if (!initialize_app()) {
         exit(1);
     }
+    if (bench_gl_errors) {
+        run_gl_error_benchmark(1000);
+        return 0;
+    }
     event_loop();
 }
 
@@ -195,12 +208,26 @@ update_scene() {
     update_flying_lights();
 }
 
+static void
+log_gl_state_counters() {
+    static Uint32 frames = 0;
+    if (++frames < GL_STATE_STATS_FRAMES) {
+        return;
+    }
+    gl_state_counters_t counters;
+    take_gl_state_counters(&counters);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GL state calls per frame: %.1f issued, %.1f elided",
+                (double) counters.issued / frames, (double) counters.elided / frames);
+    frames = 0;
+}
+
 static void
 update_screen() {
     update_scene();
     render_scene(scene);
     SDL_GL_SwapWindow(window);
     SDL_CHECK_ERROR;
+    log_gl_state_counters();
 }
 
 
@@ -215,7 +242,9 @@ static scene_object_t *create_lighter(model_t *cube_model, shader_t *model_shade
 
 static void
 initialize_scene() {
+    // every program is submitted before any asset is read, the scene ones by create_scene()
     scene = create_scene();
+    shader_t *model_shader = submit_shader("shaders/model_vertex.glsl", "shaders/model_fragment.glsl");
 
     set_scene_skybox(scene, create_cubemap("assets/textures/skybox/%s.jpg"));
 
@@ -259,7 +288,6 @@ initialize_scene() {
     memcpy(flying_spot_light, camera_light, sizeof(spot_light_t));
 
     model_t *cube_model = cube_model_create();
-    shader_t *model_shader = load_shader("shaders/model_vertex.glsl", "shaders/model_fragment.glsl");
 
     // cubes
     float scale = 2.0f;
@@ -369,11 +397,16 @@ initialize_app() {
     SDL_CHECK_ERROR;
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_CHECK_ERROR;
+    if (strict_gl_errors) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+        SDL_CHECK_ERROR;
+    }
 
     context = SDL_GL_CreateContext(window);
     SDL_CHECK_ERROR;
     SDL_GL_SetSwapInterval(1);
     SDL_CHECK_ERROR;
+    init_gl_errors(strict_gl_errors);
 
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "OpenGL information:\n\tVendor: %s\n\tRenderer: %s\n\tVersion: %s\n\tShading language: %s",
@@ -383,7 +416,10 @@ initialize_app() {
                 glGetString(GL_SHADING_LANGUAGE_VERSION)
     );
 
+    // shaders were compiled by the driver while models and textures were loading
     initialize_scene();
+    collect_shaders();
+    log_shaders_setup_time();
 
     return true;
 }
@@ -1,145 +1,745 @@
 #include "opengl/sdl_ext.h"
+#include "simulation/simulation.h"
+#include "simulation/benchmark.h"
+#include "simulation/gpu_simulation.h"
+#include "simulation/viewport.h"
+#include "simulation/frame_recorder.h"
+#include "simulation/random.h"
 #include <stdbool.h>
 #include <time.h>
 
-#define ALLOC_BUFFER calloc(WIDTH * HEIGHT, sizeof(Uint8))
-#define OFFSET(x, y) y * WIDTH + x
-
-static const int WIDTH = 640;
-static const int HEIGHT = 640;
 
 static const Uint32 FPS = 30;
-static const Uint32 FPS_SIZE_MS = 1000 / FPS;
+static const Uint32 PRESENT_STATS_FRAMES = 100;
+/**
+ * Catching up is limited to this many steps per frame, with up to MAX_SKIPPED_FRAMES frames in a row skipped for
+ * steps. Steps behind beyond that are dropped, so a simulation slower than its rate slows down instead of spiralling.
+ */
+static const int MAX_STEPS_PER_FRAME = 4;
+static const int MAX_SKIPPED_FRAMES = 3;
+static const int DEFAULT_WINDOW_SIZE = 640;
+
+typedef enum {
+    PRESENT_TEXTURE = 0,
+    PRESENT_POINTS,
+    PRESENT_LAST_MODE
+} present_mode_t;
+
+static const char *PRESENT_MODE_NAMES[PRESENT_LAST_MODE] = {"texture", "points"};
 
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
+static SDL_Texture *screen_texture = NULL;
+static SDL_GLContext context = NULL;
+
+static worker_pool_t *worker_pool = NULL;
+static simulation_t *simulation = NULL;
+static gpu_simulation_t *gpu_simulation = NULL;
+static frame_recorder_t *frame_recorder = NULL;
+
+typedef enum {
+    RUN_WINDOW = 0,
+    RUN_BENCHMARK,
+    RUN_LAYOUT_BENCHMARK,
+    RUN_VERIFY
+} run_mode_t;
+
+static run_mode_t run_mode = RUN_WINDOW;
+static unsigned int threads_number = 0;
+static bool use_gpu = false;
+static bool strict_gl_errors = false;
+static int benchmark_steps = 100;
+static const char *record_path = NULL;
+static bool seed_given = false;
+static simulation_config_t simulation_config = {
+        .width = 640,
+        .height = 640,
+        .layout = GRID_LAYOUT_INTERLEAVED,
+        .box_filter_type = BOX_FILTER_LAST_TYPE,
+        .step_mode = STEP_FULL,
+        .generations = 1,
+        .radius = 1,
+        .processes = 1
+};
 
-static Uint8 *buffer_red = NULL;
-static Uint8 *buffer_green = NULL;
-static Uint8 *buffer_blue = NULL;
+static int window_width = 0;
+static int window_height = 0;
+static viewport_t viewport;
 
-static void recalc_buffer(Uint8 **old_buffer);
+static present_mode_t present_mode = PRESENT_TEXTURE;
+static Uint64 present_ticks = 0;
+static Uint32 present_frames = 0;
+
+/**
+ * simulation steps per second, by default one step per presented frame
+ */
+static Uint32 simulation_rate = 30;
+static Uint64 pacing_start = 0;
+static Uint32 pacing_steps = 0;
+static Uint32 pacing_frames = 0;
+static Uint32 pacing_skipped_frames = 0;
+static Uint64 pacing_dropped_steps = 0;
+
+static void parse_arguments(int argc, char *argv[]);
 
 static bool initialize_app();
 
-static void add_disturbance();
+static void initialize_gl();
+
+static void initialize_simulation();
+
+static void step_app();
+
+static void present_app();
 
-static void initialize_buffers();
+static void present_points();
 
-static void update_screen();
+static void present_texture();
 
-static void recalc_buffers();
+static void switch_present_mode();
 
 static void event_loop();
 
 static void shutdown_app();
 
-int main() {
+static int verify_box_filters();
+
+static int verify_gpu_simulation();
+
+static int verify_domain_simulation();
+
+static int verify_temporal_tiling();
+
+static int verify_active_tiles();
+
+int main(int argc, char *argv[]) {
+    // internal arguments of processes started by create_domain()
+    if (argc == 5 && strcmp(argv[1], "--domain-rank") == 0 && strcmp(argv[3], "--domain-name") == 0) {
+        return run_domain_rank(argv[4], (int) strtol(argv[2], NULL, 10));
+    }
+    parse_arguments(argc, argv);
     atexit(shutdown_app);
+    if (run_mode == RUN_LAYOUT_BENCHMARK) {
+        run_layout_benchmark(simulation_config.width, simulation_config.height, benchmark_steps,
+                             simulation_config.seed);
+        return 0;
+    } else if (run_mode == RUN_BENCHMARK) {
+        worker_pool = create_worker_pool(threads_number);
+        run_step_benchmark(&simulation_config, benchmark_steps, worker_pool);
+        return 0;
+    } else if (run_mode == RUN_VERIFY) {
+        int result = verify_box_filters() | (verify_random() ? 0 : 1) | verify_temporal_tiling() |
+                     verify_active_tiles();
+        if (simulation_config.processes > 1) {
+            return result | verify_domain_simulation();
+        }
+        return use_gpu ? result | verify_gpu_simulation() : result;
+    }
     if (!initialize_app()) {
         exit(1);
     }
     event_loop();
 }
 
+static grid_layout_t
+parse_grid_layout(const char *name) {
+    for (int layout = 0; layout < GRID_LAYOUT_LAST_TYPE; layout++) {
+        if (strcmp(name, grid_layout_name(layout)) == 0) {
+            return layout;
+        }
+    }
+    SDL_Die("Unknown grid layout: %s", name);
+    return GRID_LAYOUT_INTERLEAVED;
+}
+
+static box_filter_type_t
+parse_box_filter_type(const char *name) {
+    for (int type = 0; type < BOX_FILTER_LAST_TYPE; type++) {
+        if (strcmp(name, box_filter_name(type)) == 0) {
+            return type;
+        }
+    }
+    SDL_Die("Unknown box filter: %s", name);
+    return BOX_FILTER_SCALAR;
+}
+
+static step_mode_t
+parse_step_mode(const char *name) {
+    for (int step_mode = 0; step_mode < STEP_LAST_MODE; step_mode++) {
+        if (strcmp(name, step_mode_name(step_mode)) == 0) {
+            return step_mode;
+        }
+    }
+    SDL_Die("Unknown step mode: %s", name);
+    return STEP_FULL;
+}
+
+static void
+parse_size(const char *size, int *width, int *height) {
+    if (sscanf(size, "%dx%d", width, height) != 2 || *width <= 0 || *height <= 0) {
+        SDL_Die("Invalid size: %s, expected WIDTHxHEIGHT", size);
+    }
+}
+
+static void
+parse_arguments(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            long threads = strtol(argv[++i], NULL, 10);
+            if (threads <= 0) {
+                SDL_Die("Number of threads should be positive");
+            }
+            threads_number = (unsigned int) threads;
+        } else if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            simulation_config.layout = parse_grid_layout(argv[++i]);
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            simulation_config.box_filter_type = parse_box_filter_type(argv[++i]);
+        } else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            simulation_config.step_mode = parse_step_mode(argv[++i]);
+        } else if (strcmp(argv[i], "--generations") == 0 && i + 1 < argc) {
+            simulation_config.generations = (int) strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--radius") == 0 && i + 1 < argc) {
+            simulation_config.radius = (int) strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            parse_size(argv[++i], &simulation_config.width, &simulation_config.height);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            parse_size(argv[++i], &window_width, &window_height);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+            simulation_config.processes = (int) strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            simulation_rate = (Uint32) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            simulation_config.seed = strtoull(argv[++i], NULL, 0);
+            seed_given = true;
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            benchmark_steps = (int) strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            run_mode = RUN_BENCHMARK;
+        } else if (strcmp(argv[i], "--bench-layout") == 0) {
+            run_mode = RUN_LAYOUT_BENCHMARK;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            run_mode = RUN_VERIFY;
+        } else if (strcmp(argv[i], "--gpu") == 0) {
+            use_gpu = true;
+        } else if (strcmp(argv[i], "--strict-gl") == 0) {
+            strict_gl_errors = true;
+        } else {
+            SDL_Die("Unknown argument: %s\n"
+                    "Usage: %s [--size WxH] [--window WxH] [--threads N] [--layout interleaved|planar]\n"
+                    "       [--kernel scalar|swar|sse2|avx2] [--step full|tiled|active] [--generations K]\n"
+                    "       [--radius R] [--gpu] [--processes N] [--record FILE.y4m|FILE.rgb] [--seed N]\n"
+                    "       [--rate STEPS_PER_SECOND] [--bench|--bench-layout|--verify] [--steps N] [--strict-gl]",
+                    argv[i], argv[0]);
+        }
+    }
+    if (benchmark_steps <= 0 || simulation_config.generations <= 0 || simulation_rate == 0) {
+        SDL_Die("Number of steps, generations and simulation rate should be positive");
+    }
+    if (simulation_config.box_filter_type == BOX_FILTER_LAST_TYPE) {
+        simulation_config.box_filter_type = best_box_filter_type();
+    }
+    if (simulation_config.processes < 1) {
+        SDL_Die("Number of processes should be positive");
+    }
+    if (use_gpu && simulation_config.processes > 1) {
+        SDL_Die("GPU simulation runs in a single process");
+    }
+    if (use_gpu && simulation_config.radius != 1) {
+        SDL_Die("GPU simulation supports radius 1 only");
+    }
+    if (use_gpu) {
+        // the initial state is uploaded straight from the grid buffer as RGB texture
+        simulation_config.layout = GRID_LAYOUT_INTERLEAVED;
+        simulation_config.step_mode = STEP_FULL;
+    }
+    if (threads_number == 0) {
+        threads_number = SDL_GetCPUCount();
+    }
+    // workers take bands of rows, or of tile rows in active mode, so extra ones would stay idle
+    int rows = simulation_config.step_mode == STEP_ACTIVE_TILES
+               ? (simulation_config.height + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE : simulation_config.height;
+    threads_number = SDL_min(threads_number, (unsigned int) rows);
+    if (!seed_given) {
+        simulation_config.seed = (Uint64) time(NULL) ^ SDL_GetPerformanceCounter();
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Seed: %llu", (unsigned long long) simulation_config.seed);
+    if (window_width == 0) {
+        window_width = SDL_min(simulation_config.width, DEFAULT_WINDOW_SIZE);
+        window_height = SDL_min(simulation_config.height, DEFAULT_WINDOW_SIZE);
+    }
+}
+
+/**
+ * Checks every box filter supported by the CPU against the scalar one and the running sum against direct sums,
+ * returns the exit code
+ */
+static int
+verify_box_filters() {
+    int failures = 0;
+    for (int type = BOX_FILTER_SCALAR + 1; type < BOX_FILTER_LAST_TYPE; type++) {
+        if (!box_filter_supported(type)) {
+            continue;
+        }
+        bool passed = verify_box_filter(type);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Box filter %s: %s", box_filter_name(type),
+                    passed ? "matches scalar" : "FAILED");
+        failures += !passed;
+    }
+    bool passed = verify_running_sum();
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Box filter running sum: %s", passed ? "matches direct sums" : "FAILED");
+    failures += !passed;
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Steps the same grid on the CPU and on the GPU and compares the results, returns the exit code
+ */
+static int
+verify_gpu_simulation() {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        SDL_Die("Failed to initialize SDL: %s\n", SDL_GetError());
+    }
+    window = SDL_CreateWindow("program", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, simulation_config.width,
+                              simulation_config.height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_CHECK_ERROR;
+    initialize_gl();
+    initialize_simulation();
+    grid_t *gpu_grid = create_grid(simulation_config.width, simulation_config.height, GRID_LAYOUT_INTERLEAVED);
+
+    int result = 0;
+    for (int step = 0; step < benchmark_steps && result == 0; step++) {
+        // both simulations take the same disturbances of the seed
+        step_simulation(simulation);
+        step_gpu_simulation(gpu_simulation);
+
+        read_gpu_simulation(gpu_simulation, gpu_grid);
+        size_t size = (size_t) gpu_grid->width * gpu_grid->height * gpu_grid->cell_stride;
+        if (memcmp(simulation->grid->current[0], gpu_grid->current[0], size) != 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "GPU simulation differs from CPU at step %d", step);
+            result = 1;
+        }
+    }
+    if (result == 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GPU simulation: matches CPU for %d steps", benchmark_steps);
+    }
+    destroy_grid(&gpu_grid);
+    return result;
+}
+
+static bool
+grids_equal(const grid_t *grid, const grid_t *other) {
+    int buffers = grid->layout == GRID_LAYOUT_INTERLEAVED ? 1 : CHANNELS_NUMBER;
+    for (int channel = 0; channel < buffers; channel++) {
+        if (memcmp(grid->current[channel], other->current[channel], grid_cells_size(grid)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+row_changed(const grid_t *grid, const grid_t *previous, int y) {
+    int buffers = grid->layout == GRID_LAYOUT_INTERLEAVED ? 1 : CHANNELS_NUMBER;
+    size_t row_size = (size_t) grid->width * grid->cell_stride;
+    for (int buffer = 0; buffer < buffers; buffer++) {
+        if (memcmp(grid->current[buffer] + y * row_size, previous->current[buffer] + y * row_size, row_size) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Takes the changed rows of the last step and checks they cover every row which differs from the previous grid
+ */
+static bool
+changed_rows_covered(simulation_t *simulation, const grid_t *previous) {
+    int height = simulation->grid->height;
+    bool *covered = calloc(height, sizeof(bool));
+    SDL_ALLOC_CHECK(covered)
+    int row_from;
+    int row_to;
+    for (int row = 0; take_simulation_changed_rows(simulation, row, &row_from, &row_to); row = row_to) {
+        for (int y = row_from; y < row_to; y++) {
+            covered[y] = true;
+        }
+    }
+    bool passed = true;
+    for (int y = 0; y < height && passed; y++) {
+        if (!covered[y] && row_changed(simulation->grid, previous, y)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Row %d changed but was not reported as changed", y);
+            passed = false;
+        }
+    }
+    free(covered);
+    return passed;
+}
+
+static void
+copy_grid_cells(grid_t *target, const grid_t *source) {
+    int buffers = source->layout == GRID_LAYOUT_INTERLEAVED ? 1 : CHANNELS_NUMBER;
+    for (int buffer = 0; buffer < buffers; buffer++) {
+        memcpy(target->current[buffer], source->current[buffer], grid_cells_size(source));
+    }
+}
+
+/**
+ * Steps a simulation of config and a simulation of full steps with the same seed side by side and compares the grids
+ * after every step, returns false at the first difference. Without randomize both start from zeroed grids, so only
+ * tiles around disturbances are active. With active tiles the changed rows are checked after every step as well.
+ */
+static bool
+step_mode_matches_full(const simulation_config_t *config, unsigned int workers_number, bool randomize, int steps) {
+    worker_pool_t *pool = create_worker_pool(workers_number);
+    simulation_t *tested = create_simulation(config, pool);
+    simulation_config_t reference_config = *config;
+    reference_config.step_mode = STEP_FULL;
+    simulation_t *reference = create_simulation(&reference_config, pool);
+    if (tested->temporal_tiling != NULL) {
+        // the smallest tiles, so every band holds several tiles and most rows are next to a tile edge
+        tested->temporal_tiling->tile_rows = TEMPORAL_TILING_MIN_TILE_ROWS;
+    }
+    if (randomize) {
+        randomize_simulation(tested);
+        randomize_simulation(reference);
+    }
+    grid_t *previous = create_grid(config->width, config->height, config->layout);
+
+    bool passed = true;
+    for (int step = 0; step < steps && passed; step++) {
+        copy_grid_cells(previous, tested->grid);
+        step_simulation(tested);
+        step_simulation(reference);
+        if (tested->active_region != NULL && !changed_rows_covered(tested, previous)) {
+            passed = false;
+        }
+        if (!grids_equal(tested->grid, reference->grid)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "%s steps of %dx%d %s grid, %d generations and %u workers differ from %s steps at step %d",
+                         step_mode_name(config->step_mode), config->width, config->height,
+                         grid_layout_name(config->layout), config->generations, workers_number,
+                         step_mode_name(STEP_FULL), step);
+            passed = false;
+        }
+    }
+    destroy_grid(&previous);
+    destroy_simulation(&reference);
+    destroy_simulation(&tested);
+    destroy_worker_pool(&pool);
+    return passed;
+}
+
+/**
+ * Checks temporal tiling against generation by generation steps for both layouts, several generations per step and
+ * worker counts. The height is not a multiple of the tile rows, so bands end with partial tiles. Returns the exit code.
+ */
+static int
+verify_temporal_tiling() {
+    static const int GENERATIONS[] = {2, 3, 5};
+    static const unsigned int WORKERS[] = {1, 3, 7};
+    simulation_config_t config = simulation_config;
+    config.width = 97;
+    config.height = 203;
+    config.step_mode = STEP_TEMPORAL_TILES;
+    config.radius = 1;
+    config.processes = 1;
+    int failures = 0;
+    for (int layout = 0; layout < GRID_LAYOUT_LAST_TYPE; layout++) {
+        config.layout = layout;
+        for (int i = 0; i < SDL_arraysize(GENERATIONS); i++) {
+            config.generations = GENERATIONS[i];
+            for (int j = 0; j < SDL_arraysize(WORKERS); j++) {
+                failures += !step_mode_matches_full(&config, WORKERS[j], true, 10);
+            }
+        }
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Temporal tiling: %s", failures == 0 ? "matches full steps" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Checks active tiles against full steps for both layouts on grids of partial tiles. A random grid changes
+ * everywhere and is filtered in whole rows of tiles. A wide zeroed one changes around disturbances only, so most of
+ * its active tiles are filtered in scratch windows. Returns the exit code.
+ */
+static int
+verify_active_tiles() {
+    static const int GENERATIONS[] = {1, 3};
+    static const unsigned int WORKERS[] = {1, 3};
+    simulation_config_t config = simulation_config;
+    config.height = 203;
+    config.step_mode = STEP_ACTIVE_TILES;
+    config.radius = 1;
+    config.processes = 1;
+    int failures = 0;
+    for (int layout = 0; layout < GRID_LAYOUT_LAST_TYPE; layout++) {
+        config.layout = layout;
+        for (int i = 0; i < SDL_arraysize(GENERATIONS); i++) {
+            config.generations = GENERATIONS[i];
+            for (int j = 0; j < SDL_arraysize(WORKERS); j++) {
+                config.width = 331;
+                failures += !step_mode_matches_full(&config, WORKERS[j], true, 10);
+                config.width = 2011;
+                failures += !step_mode_matches_full(&config, WORKERS[j], false, 10);
+            }
+        }
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Active tiles: %s", failures == 0 ? "match full steps" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Steps the same grid in a domain of processes and in this process alone and compares the results, returns the exit
+ * code
+ */
+static int
+verify_domain_simulation() {
+    worker_pool = create_worker_pool(threads_number);
+    simulation = create_simulation(&simulation_config, worker_pool);
+    simulation_config_t reference_config = simulation_config;
+    reference_config.processes = 1;
+    simulation_t *reference = create_simulation(&reference_config, worker_pool);
+    randomize_simulation(reference);
+
+    int result = grids_equal(simulation->grid, reference->grid) ? 0 : 1;
+    Uint64 domain_ticks = 0;
+    Uint64 reference_ticks = 0;
+    for (int step = 0; step < benchmark_steps && result == 0; step++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        step_simulation(simulation);
+        Uint64 middle = SDL_GetPerformanceCounter();
+        step_simulation(reference);
+        domain_ticks += middle - start;
+        reference_ticks += SDL_GetPerformanceCounter() - middle;
+        if (!grids_equal(simulation->grid, reference->grid)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Domain simulation differs from single process at step %d",
+                         step);
+            result = 1;
+        }
+    }
+    if (result == 0) {
+        double frequency = (double) SDL_GetPerformanceFrequency();
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Domain of %d processes: matches single process for %d steps, %.3f ms/step vs %.3f ms/step",
+                    simulation_config.processes, benchmark_steps, domain_ticks * 1000.0 / frequency / benchmark_steps,
+                    reference_ticks * 1000.0 / frequency / benchmark_steps);
+    }
+    destroy_simulation(&reference);
+    return result;
+}
+
+static void
+log_pacing(Uint64 now) {
+    double seconds = (double) (now - pacing_start) / (double) SDL_GetPerformanceFrequency();
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Pacing: %.1f steps/s of %u, %.1f frames/s of %u, %u frames skipped, %llu steps dropped",
+                pacing_steps / seconds, simulation_rate, pacing_frames / seconds, FPS, pacing_skipped_frames,
+                (unsigned long long) pacing_dropped_steps);
+    if (use_gpu) {
+        gl_state_counters_t counters;
+        take_gl_state_counters(&counters);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GL state calls per frame: %.1f issued, %.1f elided",
+                    (double) counters.issued / pacing_frames, (double) counters.elided / pacing_frames);
+    }
+    pacing_start = now;
+    pacing_steps = 0;
+    pacing_frames = 0;
+    pacing_skipped_frames = 0;
+    pacing_dropped_steps = 0;
+}
+
+/**
+ * Steps the simulation at simulation_rate and presents at FPS, both paced by the measured time. Steps due since the
+ * previous frame are run before presenting, so several steps are taken per frame when the rate is above FPS and
+ * frames without steps are presented when it is below. When stepping falls behind, frames are skipped to catch up.
+ */
 static void
 event_loop() {
     SDL_Event event;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 step_ticks = frequency / simulation_rate;
+    Uint64 frame_ticks = frequency / FPS;
+    Uint64 max_lag = step_ticks * MAX_STEPS_PER_FRAME * (MAX_SKIPPED_FRAMES + 1);
+    Uint64 previous = SDL_GetPerformanceCounter();
+    Uint64 next_frame = previous;
+    Uint64 lag = 0;
+    int skipped_frames = 0;
+    pacing_start = previous;
     while (true) {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 return;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_p) {
+                switch_present_mode();
+            } else if (event.type == SDL_MOUSEMOTION && event.motion.state & SDL_BUTTON_LMASK) {
+                pan_viewport(&viewport, event.motion.xrel, event.motion.yrel);
+            } else if (event.type == SDL_MOUSEWHEEL) {
+                int mouse_x;
+                int mouse_y;
+                SDL_GetMouseState(&mouse_x, &mouse_y);
+                zoom_viewport(&viewport, event.wheel.y, mouse_x, mouse_y);
             }
         }
-        update_screen();
-        SDL_Delay(FPS_SIZE_MS);
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        lag += now - previous;
+        previous = now;
+        if (lag > max_lag) {
+            pacing_dropped_steps += (lag - max_lag) / step_ticks;
+            lag = max_lag;
+        }
+        for (int step = 0; step < MAX_STEPS_PER_FRAME && lag >= step_ticks; step++) {
+            step_app();
+            lag -= step_ticks;
+            pacing_steps++;
+        }
+        if (lag >= step_ticks && skipped_frames < MAX_SKIPPED_FRAMES) {
+            skipped_frames++;
+            pacing_skipped_frames++;
+            continue;
+        }
+        skipped_frames = 0;
+        present_app();
+        pacing_frames++;
+
+        now = SDL_GetPerformanceCounter();
+        if (pacing_frames == PRESENT_STATS_FRAMES) {
+            log_pacing(now);
+        }
+        next_frame += frame_ticks;
+        if (next_frame > now) {
+            SDL_Delay((Uint32) ((next_frame - now) * 1000 / frequency));
+        } else {
+            // late frames are not made up for, the next one is due a full frame after this one
+            next_frame = now;
+        }
     }
 }
 
 static void
-update_screen() {
-    recalc_buffers();
-    for (int y = 0; y < HEIGHT; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            SDL_SetRenderDrawColor(renderer, buffer_red[x * HEIGHT + y], buffer_green[x * HEIGHT + y],
-                                   buffer_blue[x * HEIGHT + y], SDL_ALPHA_OPAQUE);
-            SDL_RenderDrawPoint(renderer, x, y);
+switch_present_mode() {
+    present_mode = (present_mode + 1) % PRESENT_LAST_MODE;
+    present_ticks = 0;
+    present_frames = 0;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Presenting with %s", PRESENT_MODE_NAMES[present_mode]);
+}
+
+static void
+step_app() {
+    if (gpu_simulation != NULL) {
+        step_gpu_simulation(gpu_simulation);
+        if (frame_recorder != NULL) {
+            read_gpu_simulation(gpu_simulation, simulation->grid);
+            record_frame(frame_recorder, simulation->grid);
         }
+        return;
+    }
+    step_simulation(simulation);
+    if (frame_recorder != NULL) {
+        record_frame(frame_recorder, simulation->grid);
+    }
+}
+
+static void
+present_app() {
+    if (gpu_simulation != NULL) {
+        present_gpu_simulation(gpu_simulation, window_width, window_height);
+        SDL_GL_SwapWindow(window);
+        return;
     }
 
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (present_mode == PRESENT_POINTS) {
+        present_points();
+    } else {
+        present_texture();
+    }
     SDL_RenderPresent(renderer);
+    present_ticks += SDL_GetPerformanceCounter() - start;
+
+    if (++present_frames == PRESENT_STATS_FRAMES) {
+        double ms_per_frame = (double) present_ticks * 1000.0 / (double) SDL_GetPerformanceFrequency() / present_frames;
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Presenting with %s: %.3f ms/frame", PRESENT_MODE_NAMES[present_mode],
+                    ms_per_frame);
+        present_ticks = 0;
+        present_frames = 0;
+    }
 }
 
+/**
+ * Legacy presentation, one draw call per visible cell
+ */
 static void
-recalc_buffers() {
-    add_disturbance();
-    recalc_buffer(&buffer_red);
-    recalc_buffer(&buffer_green);
-    recalc_buffer(&buffer_blue);
+present_points() {
+    grid_t *grid = simulation->grid;
+    viewport_region_t region;
+    get_viewport_region(&viewport, &region);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+    SDL_RenderSetScale(renderer, (float) region.scale, (float) region.scale);
+    for (int row = 0; row < region.rows; row++) {
+        int y = region.y + row * region.step;
+        for (int column = 0; column < region.columns; column++) {
+            int x = region.x + column * region.step;
+            SDL_SetRenderDrawColor(renderer, *grid_cell(grid, CHANNEL_RED, x, y), *grid_cell(grid, CHANNEL_GREEN, x, y),
+                                   *grid_cell(grid, CHANNEL_BLUE, x, y), SDL_ALPHA_OPAQUE);
+            SDL_RenderDrawPoint(renderer, column, row);
+        }
+    }
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
 }
 
+/**
+ * Packs visible cells of grid rows [row_from, row_to) into the texture rows of the region
+ */
 static void
-add_disturbance() {
-    for (int i = 0; i < 10; i++) {
-        int dist_x = rand() % WIDTH;
-        int dist_y = rand() % HEIGHT;
-        int offset = OFFSET(dist_x, dist_y);
-
-        buffer_red[offset] = rand() % 256;
-        buffer_green[offset] = rand() % 256;
-        buffer_blue[offset] = rand() % 256;
+update_texture_rows(const viewport_region_t *region, int row_from, int row_to) {
+    int texture_row_from = SDL_max(0, (row_from - region->y + region->step - 1) / region->step);
+    int texture_row_to = SDL_min(region->rows, (row_to - region->y + region->step - 1) / region->step);
+    if (texture_row_from >= texture_row_to) {
+        return;
+    }
+    SDL_Rect rows = {0, texture_row_from, region->columns, texture_row_to - texture_row_from};
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(screen_texture, &rows, &pixels, &pitch) != 0) {
+        SDL_Die("Failed to lock screen texture: %s", SDL_GetError());
+    }
+    for (int row = texture_row_from; row < texture_row_to; row++) {
+        sample_grid_row(simulation->grid, region->x, region->y + row * region->step, region->step, region->columns,
+                        (Uint32 *) ((Uint8 *) pixels + (row - texture_row_from) * pitch));
     }
+    SDL_UnlockTexture(screen_texture);
 }
 
+/**
+ * Packs visible cells right into the locked streaming texture and draws it scaled with a single copy. The texture
+ * is as large as the window, so the cost does not depend on the grid size. Unless the viewport moved, only rows
+ * changed since the previous frame are packed.
+ */
 static void
-recalc_buffer(Uint8 **old_buffer_ptr) {
-    Uint8 *new_buffer = ALLOC_BUFFER;
-    Uint8 *old_buffer = *old_buffer_ptr;
-
-    for (int x = 0; x < WIDTH; x++) {
-        for (int y = 0; y < HEIGHT; y++) {
-            int offset = OFFSET(x, y);
-
-            Uint16 new_value = old_buffer[offset];
-            Uint16 count = 1;
-            if (x > 0) {
-                new_value += old_buffer[offset - 1];
-                count++;
-                if (y > 0) {
-                    new_value += old_buffer[offset - WIDTH - 1];
-                    count++;
-                }
-                if (y < HEIGHT - 1) {
-                    new_value += old_buffer[offset + WIDTH - 1];
-                    count++;
-                }
-            }
-            if (x < WIDTH - 1) {
-                new_value += old_buffer[offset + 1];
-                count++;
-                if (y > 0) {
-                    new_value += old_buffer[offset - WIDTH + 1];
-                    count++;
-                }
-                if (y < HEIGHT - 1) {
-                    new_value += old_buffer[offset + WIDTH + 1];
-                    count++;
-                }
-            }
-            if (y > 0) {
-                new_value += old_buffer[offset - WIDTH];
-                count++;
-            }
-            if (y < HEIGHT - 1) {
-                new_value += old_buffer[offset + WIDTH];
-                count++;
-            }
-            new_buffer[offset] = new_value / 8;
+present_texture() {
+    viewport_region_t region;
+    get_viewport_region(&viewport, &region);
+    int row_from;
+    int row_to = 0;
+    while (take_simulation_changed_rows(simulation, row_to, &row_from, &row_to)) {
+        if (!viewport.moved) {
+            update_texture_rows(&region, row_from, row_to);
         }
     }
+    if (viewport.moved) {
+        update_texture_rows(&region, 0, simulation->grid->height);
+        viewport.moved = false;
+    }
 
-    free(*old_buffer_ptr);
-    *old_buffer_ptr = new_buffer;
+    SDL_Rect source = {0, 0, region.columns, region.rows};
+    SDL_Rect target = {region.offset_x, region.offset_y, region.columns * region.scale, region.rows * region.scale};
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, screen_texture, &source, &target);
 }
 
 static bool
@@ -147,38 +747,98 @@ initialize_app() {
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         SDL_Die("Failed to initialize SDL: %s\n", SDL_GetError());
     }
-    window = SDL_CreateWindow("program", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT,
-                              SDL_WINDOW_SHOWN);
+    Uint32 window_flags = use_gpu ? SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN : SDL_WINDOW_SHOWN;
+    window = SDL_CreateWindow("program", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_width, window_height,
+                              window_flags);
     if (!window) {
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) {
-        return false;
+    if (use_gpu) {
+        initialize_gl();
+    } else {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+        if (!renderer) {
+            return false;
+        }
+
+        screen_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                           window_width, window_height);
+        if (!screen_texture) {
+            return false;
+        }
     }
-    initialize_buffers();
+
+    init_viewport(&viewport, window_width, window_height, simulation_config.width, simulation_config.height);
+    initialize_simulation();
     return true;
 }
 
 static void
-initialize_buffers() {
-    srand(SDL_GetTicks());
-    buffer_red = ALLOC_BUFFER;
-    buffer_green = ALLOC_BUFFER;
-    buffer_blue = ALLOC_BUFFER;
-    for (int x = 0; x < WIDTH; x++) {
-        for (int y = 0; y < HEIGHT; y++) {
-            int offset = OFFSET(x, y);
-            buffer_red[offset] = rand() % 256;
-            buffer_green[offset] = rand() % 256;
-            buffer_blue[offset] = rand() % 256;
-        }
+initialize_gl() {
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_CHECK_ERROR;
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+    SDL_CHECK_ERROR;
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_CHECK_ERROR;
+    if (strict_gl_errors) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+        SDL_CHECK_ERROR;
+    }
+
+    context = SDL_GL_CreateContext(window);
+    SDL_CHECK_ERROR;
+    SDL_GL_SetSwapInterval(1);
+    SDL_CHECK_ERROR;
+    init_gl_errors(strict_gl_errors);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "OpenGL information:\n\tVendor: %s\n\tRenderer: %s\n\tVersion: %s\n\tShading language: %s",
+                glGetString(GL_VENDOR),
+                glGetString(GL_RENDERER),
+                glGetString(GL_VERSION),
+                glGetString(GL_SHADING_LANGUAGE_VERSION)
+    );
+}
+
+static void
+initialize_simulation() {
+    worker_pool = create_worker_pool(threads_number);
+
+    simulation = create_simulation(&simulation_config, worker_pool);
+    randomize_simulation(simulation);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Simulating %dx%d %s grid with %s box filter of radius %d, "
+                "%d generations per frame (%s) and %u threads",
+                simulation_config.width, simulation_config.height, grid_layout_name(simulation_config.layout),
+                box_filter_name(simulation_config.box_filter_type), simulation_config.radius,
+                simulation_config.generations,
+                step_mode_name(simulation_config.step_mode), worker_pool->workers_number);
+    if (use_gpu) {
+        gpu_simulation = create_gpu_simulation(simulation->grid, simulation_config.generations,
+                                               simulation_config.seed);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Stepping the simulation on the GPU");
+    }
+    if (record_path != NULL) {
+        frame_recorder = create_frame_recorder(record_path, simulation->grid, (int) simulation_rate);
     }
 }
 
 static void
 shutdown_app() {
+    destroy_frame_recorder(&frame_recorder);
+    destroy_gpu_simulation(&gpu_simulation);
+    if (context) {
+        SDL_GL_DeleteContext(context);
+        context = NULL;
+    }
+    destroy_simulation(&simulation);
+    destroy_worker_pool(&worker_pool);
+    if (screen_texture) {
+        SDL_DestroyTexture(screen_texture);
+        screen_texture = NULL;
+    }
     if (renderer) {
         SDL_DestroyRenderer(renderer);
         renderer = NULL;
@@ -187,18 +847,5 @@ shutdown_app() {
         SDL_DestroyWindow(window);
         window = NULL;
     }
-    if (buffer_red) {
-        free(buffer_red);
-        buffer_red = NULL;
-    }
-    if (buffer_green) {
-        free(buffer_green);
-        buffer_green = NULL;
-    }
-    if (buffer_blue) {
-        free(buffer_blue);
-        buffer_blue = NULL;
-    }
-
     SDL_Quit();
 }
\ No newline at end of file
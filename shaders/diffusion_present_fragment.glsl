@@ -0,0 +1,13 @@
+#version 430 core
+
+out vec4 color;
+
+in vec2 texture_position;
+
+layout(binding = 0) uniform sampler2D cells;
+
+void main()
+{
+    // grid rows go top to bottom, texture rows bottom to top
+    color = vec4(texture(cells, vec2(texture_position.x, 1.0 - texture_position.y)).rgb, 1.0);
+}
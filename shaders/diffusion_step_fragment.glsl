@@ -0,0 +1,22 @@
+#version 430 core
+
+out vec4 color;
+
+layout(binding = 0) uniform sampler2D cells;
+
+void main()
+{
+    ivec2 size = textureSize(cells, 0);
+    ivec2 position = ivec2(gl_FragCoord.xy);
+    uvec3 sum = uvec3(0);
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            ivec2 neighbour = position + ivec2(dx, dy);
+            if (all(greaterThanEqual(neighbour, ivec2(0))) && all(lessThan(neighbour, size))) {
+                sum += uvec3(round(texelFetch(cells, neighbour, 0).rgb * 255.0));
+            }
+        }
+    }
+    // dividing by 8 and truncating to the byte, same as the CPU box filter
+    color = vec4(vec3((sum >> 3u) & 0xffu) / 255.0, 1.0);
+}
@@ -68,12 +68,15 @@ layout(location = 0) in vec2 tex_coord;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec3 position;
 
-uniform OmniLight omni_lights[10];
-uniform int omni_lights_number;
-uniform DirectLight direct_lights[10];
-uniform int direct_lights_number;
-uniform SpotLight spot_lights[10];
-uniform int spot_lights_number;
+// one buffer shared by the programs, lights_block_t mirrors the std140 layout
+layout(std140) uniform Lights {
+    OmniLight omni_lights[10];
+    DirectLight direct_lights[10];
+    SpotLight spot_lights[10];
+    int omni_lights_number;
+    int direct_lights_number;
+    int spot_lights_number;
+};
 
 uniform vec3 camera_position;
 uniform mat3 normals_model;
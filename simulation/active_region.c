@@ -0,0 +1,215 @@
+#include "active_region.h"
+#include "../opengl/sdl_ext.h"
+
+active_region_t *
+create_active_region(const grid_t *grid, unsigned int workers_number) {
+    active_region_t *region = calloc(1, sizeof(active_region_t));
+    SDL_ALLOC_CHECK(region)
+    region->tiles_x = (grid->width + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+    region->tiles_y = (grid->height + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+    size_t tiles_number = (size_t) region->tiles_x * region->tiles_y;
+    region->dirty = calloc(tiles_number, sizeof(Uint8));
+    SDL_ALLOC_CHECK(region->dirty)
+    region->next_dirty = calloc(tiles_number, sizeof(Uint8));
+    SDL_ALLOC_CHECK(region->next_dirty)
+    region->changed_rows = calloc(region->tiles_y, sizeof(Uint8));
+    SDL_ALLOC_CHECK(region->changed_rows)
+
+    // a window is a row of tiles with halo rows, planar channels are filtered one after another
+    region->workers_number = workers_number;
+    region->scratch_size = (size_t) (ACTIVE_TILE_SIZE + 2) * grid->width * grid->cell_stride;
+    region->scratch = calloc(workers_number, sizeof(Uint8 *));
+    SDL_ALLOC_CHECK(region->scratch)
+    for (unsigned int i = 0; i < workers_number; i++) {
+        region->scratch[i] = SDL_SIMDAlloc(2 * region->scratch_size);
+        SDL_ALLOC_CHECK(region->scratch[i])
+    }
+
+    mark_active_region(region);
+    return region;
+}
+
+void
+mark_active_region(active_region_t *region) {
+    memset(region->dirty, 1, (size_t) region->tiles_x * region->tiles_y);
+    memset(region->changed_rows, 1, region->tiles_y);
+}
+
+void
+mark_active_cell(active_region_t *region, int x, int y) {
+    int tile_y = y / ACTIVE_TILE_SIZE;
+    region->dirty[tile_y * region->tiles_x + x / ACTIVE_TILE_SIZE] = 1;
+    region->changed_rows[tile_y] = 1;
+}
+
+static bool
+tile_active(const active_region_t *region, int tile_x, int tile_y) {
+    for (int y = SDL_max(0, tile_y - 1); y <= SDL_min(region->tiles_y - 1, tile_y + 1); y++) {
+        for (int x = SDL_max(0, tile_x - 1); x <= SDL_min(region->tiles_x - 1, tile_x + 1); x++) {
+            if (region->dirty[y * region->tiles_x + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Filters columns [column_from, column_to) of rows [row_from, row_to) of a single buffer. The window with one cell
+ * of halo around is copied to the scratch and processed as a grid of its own: its borders are grid borders only
+ * where the window is clamped by the grid, cells next to other borders are never copied back.
+ */
+static void
+filter_window(const Uint8 *source, Uint8 *target, int width, int height, int channels, box_filter_t box_filter,
+              box_filter_scratch_t *filter_scratch, int column_from, int column_to, int row_from, int row_to,
+              Uint8 *scratch, size_t scratch_size) {
+    int window_left = SDL_max(0, column_from - 1);
+    int window_top = SDL_max(0, row_from - 1);
+    int window_width = SDL_min(width, column_to + 1) - window_left;
+    int window_height = SDL_min(height, row_to + 1) - window_top;
+    size_t row_size = (size_t) width * channels;
+    size_t window_row_size = (size_t) window_width * channels;
+
+    Uint8 *window_source = scratch;
+    Uint8 *window_target = scratch + scratch_size;
+    for (int y = 0; y < window_height; y++) {
+        memcpy(window_source + y * window_row_size, source + (window_top + y) * row_size + window_left * channels,
+               window_row_size);
+    }
+    box_filter(window_source, window_target, window_width, window_height, channels, row_from - window_top,
+               row_to - window_top, filter_scratch);
+    size_t offset = (size_t) (column_from - window_left) * channels;
+    size_t copy_size = (size_t) (column_to - column_from) * channels;
+    for (int y = row_from; y < row_to; y++) {
+        memcpy(target + y * row_size + column_from * channels,
+               window_target + (y - window_top) * window_row_size + offset, copy_size);
+    }
+}
+
+/**
+ * Filters columns [column_from, column_to) of rows [row_from, row_to) of all channels
+ */
+static void
+filter_tiles(active_region_t *region, unsigned int worker_index, grid_t *grid, box_filter_t box_filter,
+             box_filter_scratch_t *filter_scratch, int column_from, int column_to, int row_from, int row_to) {
+    Uint8 *scratch = region->scratch[worker_index];
+    if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+        filter_window(grid->current[0], grid->next[0], grid->width, grid->height, CHANNELS_NUMBER, box_filter,
+                      filter_scratch, column_from, column_to, row_from, row_to, scratch, region->scratch_size);
+    } else {
+        for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+            filter_window(grid->current[channel], grid->next[channel], grid->width, grid->height, 1, box_filter,
+                          filter_scratch, column_from, column_to, row_from, row_to, scratch, region->scratch_size);
+        }
+    }
+}
+
+static bool
+tile_changed(const grid_t *grid, int column_from, int column_to, int row_from, int row_to) {
+    int buffers_number = grid->layout == GRID_LAYOUT_INTERLEAVED ? 1 : CHANNELS_NUMBER;
+    size_t row_size = (size_t) grid->width * grid->cell_stride;
+    size_t offset = (size_t) column_from * grid->cell_stride;
+    size_t compare_size = (size_t) (column_to - column_from) * grid->cell_stride;
+    for (int buffer = 0; buffer < buffers_number; buffer++) {
+        for (int y = row_from; y < row_to; y++) {
+            if (memcmp(grid->current[buffer] + y * row_size + offset, grid->next[buffer] + y * row_size + offset,
+                       compare_size) != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void
+step_grid_tiles_active(active_region_t *region, unsigned int worker_index, grid_t *grid, box_filter_t box_filter,
+                       box_filter_scratch_t *filter_scratch, int tile_row_from, int tile_row_to) {
+    for (int tile_y = tile_row_from; tile_y < tile_row_to; tile_y++) {
+        int row_from = tile_y * ACTIVE_TILE_SIZE;
+        int row_to = SDL_min(row_from + ACTIVE_TILE_SIZE, grid->height);
+        // flags of active tiles are kept in next_dirty until the tiles are computed
+        Uint8 *next_dirty = region->next_dirty + tile_y * region->tiles_x;
+        int active_tiles = 0;
+        for (int tile_x = 0; tile_x < region->tiles_x; tile_x++) {
+            next_dirty[tile_x] = tile_active(region, tile_x, tile_y);
+            active_tiles += next_dirty[tile_x];
+        }
+        if (active_tiles == 0) {
+            continue;
+        }
+
+        if (active_tiles * 2 >= region->tiles_x) {
+            // filtering inactive tiles leaves them as they are, it is cheaper than copying windows of most of the row
+            step_grid_rows(grid, box_filter, filter_scratch, row_from, row_to);
+        } else {
+            // consecutive active tiles are filtered in a single window
+            int tile_x = 0;
+            while (tile_x < region->tiles_x) {
+                if (!next_dirty[tile_x]) {
+                    tile_x++;
+                    continue;
+                }
+                int run_from = tile_x;
+                while (tile_x < region->tiles_x && next_dirty[tile_x]) {
+                    tile_x++;
+                }
+                filter_tiles(region, worker_index, grid, box_filter, filter_scratch, run_from * ACTIVE_TILE_SIZE,
+                             SDL_min(tile_x * ACTIVE_TILE_SIZE, grid->width), row_from, row_to);
+            }
+        }
+
+        bool row_changed = false;
+        for (int tile_x = 0; tile_x < region->tiles_x; tile_x++) {
+            if (next_dirty[tile_x]) {
+                int column_from = tile_x * ACTIVE_TILE_SIZE;
+                int column_to = SDL_min(column_from + ACTIVE_TILE_SIZE, grid->width);
+                next_dirty[tile_x] = tile_changed(grid, column_from, column_to, row_from, row_to);
+                row_changed |= next_dirty[tile_x];
+            }
+        }
+        if (row_changed) {
+            region->changed_rows[tile_y] = 1;
+        }
+    }
+}
+
+void
+swap_active_region(active_region_t *region) {
+    Uint8 *dirty = region->dirty;
+    region->dirty = region->next_dirty;
+    region->next_dirty = dirty;
+}
+
+bool
+take_changed_rows(active_region_t *region, int height, int row, int *row_from, int *row_to) {
+    int tile_y = (row + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+    while (tile_y < region->tiles_y && !region->changed_rows[tile_y]) {
+        tile_y++;
+    }
+    if (tile_y == region->tiles_y) {
+        return false;
+    }
+    *row_from = tile_y * ACTIVE_TILE_SIZE;
+    while (tile_y < region->tiles_y && region->changed_rows[tile_y]) {
+        region->changed_rows[tile_y++] = 0;
+    }
+    *row_to = SDL_min(tile_y * ACTIVE_TILE_SIZE, height);
+    return true;
+}
+
+void
+destroy_active_region(active_region_t **pp_region) {
+    active_region_t *region = *pp_region;
+    if (region == NULL) {
+        return;
+    }
+    for (unsigned int i = 0; i < region->workers_number; i++) {
+        SDL_SIMDFree(region->scratch[i]);
+    }
+    free(region->scratch);
+    free(region->changed_rows);
+    free(region->next_dirty);
+    free(region->dirty);
+    free(region);
+    *pp_region = NULL;
+}
@@ -0,0 +1,72 @@
+#ifndef SDL_TEST_ACTIVE_REGION_H
+#define SDL_TEST_ACTIVE_REGION_H
+
+#include "grid.h"
+#include "box_filter.h"
+#include <stdbool.h>
+
+#define ACTIVE_TILE_SIZE 32
+
+/**
+ * Tracking of grid tiles which may change on the next generation. A tile is dirty when its current cells differ from
+ * the next buffers, e.g. it was changed by the last generation or disturbed. Only tiles with a dirty tile in their
+ * 3x3 neighbourhood are recomputed, others already hold the result in the next buffers.
+ * Runs of active tiles are filtered in per-worker scratch windows, full rows of active tiles right in the grid.
+ */
+typedef struct active_region {
+    int tiles_x;
+    int tiles_y;
+    /**
+     * tiles_x * tiles_y flags of tiles with current cells different from the next buffers
+     */
+    Uint8 *dirty;
+    /**
+     * same flags for the generation being computed, swapped with dirty after a generation
+     */
+    Uint8 *next_dirty;
+    /**
+     * tiles_y flags of tile rows changed since the rows were taken for presentation
+     */
+    Uint8 *changed_rows;
+    /**
+     * size of one of two scratch buffers of a worker
+     */
+    size_t scratch_size;
+    unsigned int workers_number;
+    Uint8 **scratch;
+} active_region_t;
+
+/**
+ * Creates the region with all tiles dirty
+ */
+active_region_t *create_active_region(const grid_t *grid, unsigned int workers_number);
+
+/**
+ * Marks all tiles dirty, e.g. after the grid was rewritten outside of the simulation
+ */
+void mark_active_region(active_region_t *region);
+
+/**
+ * Marks the tile containing the cell dirty
+ */
+void mark_active_cell(active_region_t *region, int x, int y);
+
+/**
+ * Computes tile rows [tile_row_from, tile_row_to) of the next buffers of the grid, skipping tiles which can not change
+ */
+void step_grid_tiles_active(active_region_t *region, unsigned int worker_index, grid_t *grid, box_filter_t box_filter,
+                            box_filter_scratch_t *filter_scratch, int tile_row_from, int tile_row_to);
+
+/**
+ * Makes flags of the computed generation current, call with swap_grid_buffers()
+ */
+void swap_active_region(active_region_t *region);
+
+/**
+ * Finds the first span of grid rows at or after the row changed since it was taken and clears its changed state
+ */
+bool take_changed_rows(active_region_t *region, int height, int row, int *row_from, int *row_to);
+
+void destroy_active_region(active_region_t **pp_region);
+
+#endif //SDL_TEST_ACTIVE_REGION_H
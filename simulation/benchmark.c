@@ -0,0 +1,280 @@
+#include "benchmark.h"
+#include "../opengl/sdl_ext.h"
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+#define CACHE_COUNTERS_NUMBER 2
+
+typedef struct cache_counters {
+    int descriptors[CACHE_COUNTERS_NUMBER];
+    Uint64 values[CACHE_COUNTERS_NUMBER];
+} cache_counters_t;
+
+typedef struct layout_result {
+    double ms_per_step;
+    /**
+     * negative if the counter is not available
+     */
+    double misses_per_step[CACHE_COUNTERS_NUMBER];
+} layout_result_t;
+
+static const char *CACHE_COUNTER_NAMES[CACHE_COUNTERS_NUMBER] = {"L1D misses", "LLC misses"};
+
+#ifdef __linux__
+
+static int
+open_cache_counter(Uint32 type, Uint64 config) {
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+#endif
+
+/**
+ * Opens hardware cache counters for the current thread, counters unavailable on this system are left at -1
+ */
+static void
+open_cache_counters(cache_counters_t *counters) {
+    for (int i = 0; i < CACHE_COUNTERS_NUMBER; i++) {
+        counters->descriptors[i] = -1;
+        counters->values[i] = 0;
+    }
+#ifdef __linux__
+    counters->descriptors[0] = open_cache_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                                                      PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                                                      PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    counters->descriptors[1] = open_cache_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+}
+
+static void
+start_cache_counters(cache_counters_t *counters) {
+#ifdef __linux__
+    for (int i = 0; i < CACHE_COUNTERS_NUMBER; i++) {
+        if (counters->descriptors[i] >= 0) {
+            ioctl(counters->descriptors[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->descriptors[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+static void
+stop_cache_counters(cache_counters_t *counters) {
+#ifdef __linux__
+    for (int i = 0; i < CACHE_COUNTERS_NUMBER; i++) {
+        if (counters->descriptors[i] >= 0) {
+            ioctl(counters->descriptors[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counters->descriptors[i], &counters->values[i], sizeof(Uint64)) != sizeof(Uint64)) {
+                counters->values[i] = 0;
+            }
+        }
+    }
+#endif
+}
+
+static void
+close_cache_counters(cache_counters_t *counters) {
+#ifdef __linux__
+    for (int i = 0; i < CACHE_COUNTERS_NUMBER; i++) {
+        if (counters->descriptors[i] >= 0) {
+            close(counters->descriptors[i]);
+            counters->descriptors[i] = -1;
+        }
+    }
+#endif
+}
+
+/**
+ * The original stepping: x in the outer loop over the row-major planes, so every inner step strides by the width
+ */
+static void
+step_grid_column_walk(grid_t *grid) {
+    int width = grid->width;
+    int height = grid->height;
+    for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+        const Uint8 *old_buffer = grid->current[channel];
+        Uint8 *new_buffer = grid->next[channel];
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                int offset = y * width + x;
+
+                Uint16 new_value = old_buffer[offset];
+                if (x > 0) {
+                    new_value += old_buffer[offset - 1];
+                    if (y > 0) {
+                        new_value += old_buffer[offset - width - 1];
+                    }
+                    if (y < height - 1) {
+                        new_value += old_buffer[offset + width - 1];
+                    }
+                }
+                if (x < width - 1) {
+                    new_value += old_buffer[offset + 1];
+                    if (y > 0) {
+                        new_value += old_buffer[offset - width + 1];
+                    }
+                    if (y < height - 1) {
+                        new_value += old_buffer[offset + width + 1];
+                    }
+                }
+                if (y > 0) {
+                    new_value += old_buffer[offset - width];
+                }
+                if (y < height - 1) {
+                    new_value += old_buffer[offset + width];
+                }
+                new_buffer[offset] = new_value / 8;
+            }
+        }
+    }
+}
+
+/**
+ * Runs steps of the grid with the box_filter, or with the column walk if box_filter is NULL
+ */
+static layout_result_t
+benchmark_layout(grid_t *grid, box_filter_t box_filter, int steps, Uint64 seed) {
+    cache_counters_t counters;
+    open_cache_counters(&counters);
+    randomize_grid(grid, seed, 0, grid_cells_size(grid));
+    box_filter_scratch_t *scratch = create_grid_filter_scratch(grid);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    start_cache_counters(&counters);
+    for (int step = 0; step < steps; step++) {
+        if (box_filter == NULL) {
+            step_grid_column_walk(grid);
+        } else {
+            step_grid_rows(grid, box_filter, scratch, 0, grid->height);
+        }
+        swap_grid_buffers(grid);
+    }
+    stop_cache_counters(&counters);
+    destroy_box_filter_scratch(&scratch);
+
+    layout_result_t result;
+    result.ms_per_step = (double) (SDL_GetPerformanceCounter() - start) * 1000.0 /
+                         (double) SDL_GetPerformanceFrequency() / steps;
+    for (int i = 0; i < CACHE_COUNTERS_NUMBER; i++) {
+        result.misses_per_step[i] = counters.descriptors[i] < 0 ? -1.0 : (double) counters.values[i] / steps;
+    }
+    close_cache_counters(&counters);
+    return result;
+}
+
+static void
+log_layout_result(const char *name, layout_result_t *result, layout_result_t *baseline) {
+    char misses[160] = "";
+    int length = 0;
+    for (int i = 0; i < CACHE_COUNTERS_NUMBER; i++) {
+        if (result->misses_per_step[i] < 0) {
+            length += snprintf(misses + length, sizeof(misses) - length, "; %s: n/a", CACHE_COUNTER_NAMES[i]);
+        } else {
+            length += snprintf(misses + length, sizeof(misses) - length, "; %s: %.0f/step (%.2fx)",
+                               CACHE_COUNTER_NAMES[i], result->misses_per_step[i],
+                               baseline->misses_per_step[i] > 0 ?
+                               result->misses_per_step[i] / baseline->misses_per_step[i] : 1.0);
+        }
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%-32s %9.3f ms/step (%.2fx)%s", name, result->ms_per_step,
+                result->ms_per_step / baseline->ms_per_step, misses);
+}
+
+void
+run_layout_benchmark(int width, int height, int steps, Uint64 seed) {
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Layout benchmark: %dx%d grid, %d steps, single thread", width, height,
+                steps);
+    box_filter_type_t best_type = best_box_filter_type();
+    char name[64];
+
+    grid_t *grid = create_grid(width, height, GRID_LAYOUT_PLANAR);
+    layout_result_t baseline = benchmark_layout(grid, NULL, steps, seed);
+    log_layout_result("planar, column walk, scalar", &baseline, &baseline);
+
+    layout_result_t result = benchmark_layout(grid, box_filter_scalar, steps, seed);
+    log_layout_result("planar, row-major, scalar", &result, &baseline);
+
+    result = benchmark_layout(grid, get_box_filter(best_type), steps, seed);
+    snprintf(name, sizeof(name), "planar, row-major, %s", box_filter_name(best_type));
+    log_layout_result(name, &result, &baseline);
+    destroy_grid(&grid);
+
+    grid = create_grid(width, height, GRID_LAYOUT_INTERLEAVED);
+    result = benchmark_layout(grid, box_filter_scalar, steps, seed);
+    log_layout_result("interleaved, row-major, scalar", &result, &baseline);
+
+    result = benchmark_layout(grid, get_box_filter(best_type), steps, seed);
+    snprintf(name, sizeof(name), "interleaved, row-major, %s", box_filter_name(best_type));
+    log_layout_result(name, &result, &baseline);
+    destroy_grid(&grid);
+}
+
+static void
+benchmark_steps(simulation_config_t *config, int steps, worker_pool_t *worker_pool) {
+    simulation_t *simulation = create_simulation(config, worker_pool);
+    randomize_simulation(simulation);
+    // warming up caches and workers
+    step_simulation(simulation);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int step = 0; step < steps; step++) {
+        step_simulation(simulation);
+    }
+    double seconds = (double) (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+    destroy_simulation(&simulation);
+
+    double cells_per_second = (double) config->width * config->height * config->generations * steps / seconds;
+    double bytes_per_second = cells_per_second * CHANNELS_NUMBER * 2;
+    const char *kernel_name = config->radius > 1 ? "running" : box_filter_name(config->box_filter_type);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%-12s %-8s %-6s %10.3f %12.1f %10.2f", grid_layout_name(config->layout),
+                kernel_name, step_mode_name(config->step_mode), 1e9 / cells_per_second, cells_per_second / 1e6,
+                bytes_per_second / 1e9);
+}
+
+void
+run_step_benchmark(const simulation_config_t *config, int steps, worker_pool_t *worker_pool) {
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Step benchmark: %dx%d grid, radius %d, %d steps of %d generations, %u threads, %d processes",
+                config->width, config->height, config->radius, steps, config->generations, worker_pool->workers_number,
+                config->processes);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%-12s %-8s %-6s %10s %12s %10s", "layout", "kernel", "mode", "ns/cell",
+                "Mcells/s", "GB/s");
+    simulation_config_t variant = *config;
+    for (variant.layout = 0; variant.layout < GRID_LAYOUT_LAST_TYPE; variant.layout++) {
+        if (variant.radius > 1) {
+            // wider neighbourhoods have the only kernel and full steps only
+            variant.step_mode = STEP_FULL;
+            benchmark_steps(&variant, steps, worker_pool);
+            continue;
+        }
+        for (variant.box_filter_type = 0; variant.box_filter_type < BOX_FILTER_LAST_TYPE; variant.box_filter_type++) {
+            if (!box_filter_supported(variant.box_filter_type)) {
+                continue;
+            }
+            for (variant.step_mode = 0; variant.step_mode < STEP_LAST_MODE; variant.step_mode++) {
+                if (variant.step_mode == STEP_TEMPORAL_TILES && variant.generations == 1) {
+                    continue;
+                }
+                if (variant.processes > 1 && variant.step_mode != STEP_FULL) {
+                    continue;
+                }
+                benchmark_steps(&variant, steps, worker_pool);
+            }
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef SDL_TEST_BENCHMARK_H
+#define SDL_TEST_BENCHMARK_H
+
+#include "grid.h"
+#include "box_filter.h"
+#include "worker_pool.h"
+#include "simulation.h"
+
+/**
+ * Steps grids of every layout headless and logs time and cache misses per step. The baseline is the original
+ * stepping: planar buffers walked column by column with the scalar filter.
+ */
+void run_layout_benchmark(int width, int height, int steps, Uint64 seed);
+
+/**
+ * Runs simulation steps headless for every layout, every box filter supported by the CPU and every step mode useful
+ * for configured generations per step, or the running sum filter alone for radius above 1. Logs ns/cell, cells/s and
+ * the effective memory bandwidth per generation (each generation reads and writes every channel byte once).
+ */
+void run_step_benchmark(const simulation_config_t *config, int steps, worker_pool_t *worker_pool);
+
+#endif //SDL_TEST_BENCHMARK_H
@@ -0,0 +1,323 @@
+#include "box_filter.h"
+#include "../opengl/sdl_ext.h"
+
+static const char *BOX_FILTER_NAMES[BOX_FILTER_LAST_TYPE] = {"scalar", "swar", "sse2", "avx2"};
+
+box_filter_scratch_t *
+create_box_filter_scratch(int width, int channels) {
+    box_filter_scratch_t *scratch = calloc(1, sizeof(box_filter_scratch_t));
+    SDL_ALLOC_CHECK(scratch)
+    scratch->width = width;
+    scratch->channels = channels;
+    scratch->columns = calloc((size_t) (width + 2) * channels, sizeof(Uint16));
+    SDL_ALLOC_CHECK(scratch->columns)
+    scratch->zero_row = calloc((size_t) width * channels, sizeof(Uint8));
+    SDL_ALLOC_CHECK(scratch->zero_row)
+    return scratch;
+}
+
+void
+destroy_box_filter_scratch(box_filter_scratch_t **pp_scratch) {
+    box_filter_scratch_t *scratch = *pp_scratch;
+    if (scratch == NULL) {
+        return;
+    }
+    free(scratch->zero_row);
+    free(scratch->columns);
+    free(scratch);
+    *pp_scratch = NULL;
+}
+
+void
+box_filter_scalar(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                  int row_to, box_filter_scratch_t *scratch) {
+    int row_size = width * channels;
+    for (int y = row_from; y < row_to; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int channel = 0; channel < channels; channel++) {
+                int offset = y * row_size + x * channels + channel;
+
+                Uint16 new_value = source[offset];
+                if (x > 0) {
+                    new_value += source[offset - channels];
+                    if (y > 0) {
+                        new_value += source[offset - row_size - channels];
+                    }
+                    if (y < height - 1) {
+                        new_value += source[offset + row_size - channels];
+                    }
+                }
+                if (x < width - 1) {
+                    new_value += source[offset + channels];
+                    if (y > 0) {
+                        new_value += source[offset - row_size + channels];
+                    }
+                    if (y < height - 1) {
+                        new_value += source[offset + row_size + channels];
+                    }
+                }
+                if (y > 0) {
+                    new_value += source[offset - row_size];
+                }
+                if (y < height - 1) {
+                    new_value += source[offset + row_size];
+                }
+                target[offset] = new_value / 8;
+            }
+        }
+    }
+}
+
+/**
+ * Exact division of numerators below 2^24 by the multiplication with the rounded up reciprocal
+ */
+typedef struct reciprocal {
+    Uint64 multiplier;
+    int shift;
+} reciprocal_t;
+
+#define RECIPROCAL_NUMERATOR_BITS 24
+
+static reciprocal_t
+get_reciprocal(Uint32 divisor) {
+    int divisor_bits = 0;
+    while ((1U << divisor_bits) < divisor) {
+        divisor_bits++;
+    }
+    reciprocal_t reciprocal;
+    reciprocal.shift = RECIPROCAL_NUMERATOR_BITS + divisor_bits;
+    reciprocal.multiplier = (((Uint64) 1 << reciprocal.shift) + divisor - 1) / divisor;
+    return reciprocal;
+}
+
+static inline Uint8
+divide(Uint32 numerator, reciprocal_t reciprocal) {
+    return (Uint8) ((numerator * reciprocal.multiplier) >> reciprocal.shift);
+}
+
+/**
+ * Slides the window of 2 * radius + 1 column sums of the same channel along the row, the window is clipped by the
+ * row ends
+ */
+static inline void
+sum_window_row(const Uint16 *columns, Uint8 *target, int width, int channels, int radius, reciprocal_t divisor) {
+    int row_size = width * channels;
+    int span = radius * channels;
+    for (int channel = 0; channel < channels; channel++) {
+        Uint32 window = 0;
+        for (int x = channel; x <= span + channel && x < row_size; x += channels) {
+            window += columns[x];
+        }
+        // cells whose window is clipped on the left, then the right edge leaves the row, then the full window slides
+        int x = channel;
+        for (; x < row_size && x < span; x += channels) {
+            target[x] = divide(window, divisor);
+            if (x + span + channels < row_size) {
+                window += columns[x + span + channels];
+            }
+        }
+        for (; x + span + channels < row_size; x += channels) {
+            target[x] = divide(window, divisor);
+            window += columns[x + span + channels] - columns[x - span];
+        }
+        for (; x < row_size; x += channels) {
+            target[x] = divide(window, divisor);
+            window -= columns[x - span];
+        }
+    }
+}
+
+void
+box_filter_running_sum(const Uint8 *source, Uint8 *target, int width, int height, int channels, int radius,
+                       int row_from, int row_to, box_filter_scratch_t *scratch) {
+    if (row_from >= row_to) {
+        return;
+    }
+    int row_size = width * channels;
+    // the window sum is below 2^24 for radii up to BOX_FILTER_MAX_RADIUS
+    reciprocal_t divisor = get_reciprocal((Uint32) ((2 * radius + 1) * (2 * radius + 1) - 1));
+    Uint16 *columns = scratch->columns;
+    memset(columns, 0, row_size * sizeof(Uint16));
+    for (int y = SDL_max(0, row_from - radius); y <= SDL_min(height - 1, row_from + radius); y++) {
+        const Uint8 *row = source + (size_t) y * row_size;
+        for (int x = 0; x < row_size; x++) {
+            columns[x] += row[x];
+        }
+    }
+
+    for (int y = row_from; y < row_to; y++) {
+        sum_window_row(columns, target + (size_t) y * row_size, width, channels, radius, divisor);
+        // moving column sums one row down
+        if (y + radius + 1 < height) {
+            const Uint8 *down = source + (size_t) (y + radius + 1) * row_size;
+            for (int x = 0; x < row_size; x++) {
+                columns[x] += down[x];
+            }
+        }
+        if (y - radius >= 0) {
+            const Uint8 *up = source + (size_t) (y - radius) * row_size;
+            for (int x = 0; x < row_size; x++) {
+                columns[x] -= up[x];
+            }
+        }
+    }
+}
+
+bool
+box_filter_supported(box_filter_type_t type) {
+    switch (type) {
+        case BOX_FILTER_SCALAR:
+        case BOX_FILTER_SWAR:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case BOX_FILTER_SSE2:
+            return SDL_HasSSE2();
+        case BOX_FILTER_AVX2:
+            return SDL_HasAVX2();
+#endif
+        default:
+            return false;
+    }
+}
+
+box_filter_type_t
+best_box_filter_type() {
+    for (int type = BOX_FILTER_LAST_TYPE - 1; type > BOX_FILTER_SCALAR; type--) {
+        if (box_filter_supported(type)) {
+            return type;
+        }
+    }
+    return BOX_FILTER_SCALAR;
+}
+
+box_filter_t
+get_box_filter(box_filter_type_t type) {
+    if (!box_filter_supported(type)) {
+        SDL_Die("Box filter %s is not supported by this CPU", box_filter_name(type));
+    }
+    switch (type) {
+        case BOX_FILTER_SWAR:
+            return box_filter_swar;
+#if defined(__x86_64__) || defined(__i386__)
+        case BOX_FILTER_SSE2:
+            return box_filter_sse2;
+        case BOX_FILTER_AVX2:
+            return box_filter_avx2;
+#endif
+        default:
+            return box_filter_scalar;
+    }
+}
+
+const char *
+box_filter_name(box_filter_type_t type) {
+    return type < BOX_FILTER_LAST_TYPE ? BOX_FILTER_NAMES[type] : "unknown";
+}
+
+static const int SIZES[][2] = {{1, 1}, {1, 7}, {5, 2}, {8, 8}, {17, 3}, {31, 33}, {64, 9}, {129, 65}};
+
+bool
+verify_box_filter(box_filter_type_t type) {
+    box_filter_t box_filter = get_box_filter(type);
+    // the last of the sizes is the widest
+    box_filter_scratch_t *scratch = create_box_filter_scratch(SIZES[SDL_arraysize(SIZES) - 1][0], 3);
+    bool passed = true;
+    for (int i = 0; i < SDL_arraysize(SIZES) && passed; i++) {
+        int width = SIZES[i][0];
+        int height = SIZES[i][1];
+        for (int channels = 1; channels <= 3 && passed; channels += 2) {
+            size_t size = (size_t) width * height * channels;
+            Uint8 *source = malloc(size);
+            Uint8 *expected = malloc(size);
+            Uint8 *actual = malloc(size);
+            SDL_ALLOC_CHECK(source)
+            SDL_ALLOC_CHECK(expected)
+            SDL_ALLOC_CHECK(actual)
+            for (size_t j = 0; j < size; j++) {
+                source[j] = rand() % 256;
+            }
+            // the grid is filtered in two bands to cover rows next to band borders
+            box_filter_scalar(source, expected, width, height, channels, 0, height, scratch);
+            box_filter(source, actual, width, height, channels, 0, height / 2, scratch);
+            box_filter(source, actual, width, height, channels, height / 2, height, scratch);
+            if (memcmp(expected, actual, size) != 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                             "Box filter %s differs from scalar on %dx%d grid of %d channels", box_filter_name(type),
+                             width, height, channels);
+                passed = false;
+            }
+            free(actual);
+            free(expected);
+            free(source);
+        }
+    }
+    destroy_box_filter_scratch(&scratch);
+    return passed;
+}
+
+/**
+ * Sums the zero padded (2 * radius + 1)^2 neighbourhood of every cell directly
+ */
+static void
+box_filter_brute_force(const Uint8 *source, Uint8 *target, int width, int height, int channels, int radius) {
+    Uint32 divisor = (Uint32) ((2 * radius + 1) * (2 * radius + 1) - 1);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int channel = 0; channel < channels; channel++) {
+                Uint32 sum = 0;
+                for (int window_y = SDL_max(0, y - radius); window_y <= SDL_min(height - 1, y + radius); window_y++) {
+                    for (int window_x = SDL_max(0, x - radius); window_x <= SDL_min(width - 1, x + radius);
+                         window_x++) {
+                        sum += source[(window_y * width + window_x) * channels + channel];
+                    }
+                }
+                target[(y * width + x) * channels + channel] = sum / divisor;
+            }
+        }
+    }
+}
+
+bool
+verify_running_sum() {
+    static const int RADII[] = {1, 2, 5, BOX_FILTER_MAX_RADIUS};
+    // the last of the sizes is the widest
+    box_filter_scratch_t *scratch = create_box_filter_scratch(SIZES[SDL_arraysize(SIZES) - 1][0], 3);
+    bool passed = true;
+    for (int i = 0; i < SDL_arraysize(SIZES) && passed; i++) {
+        int width = SIZES[i][0];
+        int height = SIZES[i][1];
+        for (int channels = 1; channels <= 3 && passed; channels += 2) {
+            size_t size = (size_t) width * height * channels;
+            Uint8 *source = malloc(size);
+            Uint8 *expected = malloc(size);
+            Uint8 *actual = malloc(size);
+            SDL_ALLOC_CHECK(source)
+            SDL_ALLOC_CHECK(expected)
+            SDL_ALLOC_CHECK(actual)
+            for (size_t j = 0; j < size; j++) {
+                source[j] = rand() % 256;
+            }
+            for (int j = 0; j < SDL_arraysize(RADII) && passed; j++) {
+                int radius = RADII[j];
+                if (radius == 1) {
+                    box_filter_scalar(source, expected, width, height, channels, 0, height, NULL);
+                } else {
+                    box_filter_brute_force(source, expected, width, height, channels, radius);
+                }
+                box_filter_running_sum(source, actual, width, height, channels, radius, 0, height / 2, scratch);
+                box_filter_running_sum(source, actual, width, height, channels, radius, height / 2, height, scratch);
+                if (memcmp(expected, actual, size) != 0) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                                 "Running sum of radius %d differs on %dx%d grid of %d channels", radius, width,
+                                 height, channels);
+                    passed = false;
+                }
+            }
+            free(actual);
+            free(expected);
+            free(source);
+        }
+    }
+    destroy_box_filter_scratch(&scratch);
+    return passed;
+}
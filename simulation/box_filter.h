@@ -0,0 +1,103 @@
+#ifndef SDL_TEST_BOX_FILTER_H
+#define SDL_TEST_BOX_FILTER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+/**
+ * Column sums of the running sum filter are kept in 16 bits
+ */
+#define BOX_FILTER_MAX_RADIUS 127
+
+typedef enum {
+    BOX_FILTER_SCALAR = 0,
+    BOX_FILTER_SWAR,
+    BOX_FILTER_SSE2,
+    BOX_FILTER_AVX2,
+    BOX_FILTER_LAST_TYPE
+} box_filter_type_t;
+
+/**
+ * Line buffers of the filters, allocated once per worker for rows of up to width cells of channels bytes, so kernels
+ * need no stack space proportional to the grid width
+ */
+typedef struct box_filter_scratch {
+    int width;
+    int channels;
+    /**
+     * column sums of a row with room for a zero cell on both sides, (width + 2) * channels items
+     */
+    Uint16 *columns;
+    /**
+     * width * channels zero bytes read in place of rows outside of the grid
+     */
+    Uint8 *zero_row;
+} box_filter_scratch_t;
+
+box_filter_scratch_t *create_box_filter_scratch(int width, int channels);
+
+void destroy_box_filter_scratch(box_filter_scratch_t **pp_scratch);
+
+/**
+ * Computes rows [row_from, row_to) of the target as a sum of the 3x3 neighbourhood of each source cell divided by 8
+ * and truncated to the byte. Cells outside the grid are counted as zeroes. Source rows outside of the range are
+ * only read, so bands of the same grid may be processed independently.
+ * Each cell holds channels interleaved bytes, every channel is filtered on its own in the same sweep.
+ * The scratch of the calling worker should fit rows of the width and channels.
+ */
+typedef void (*box_filter_t)(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                             int row_to, box_filter_scratch_t *scratch);
+
+/**
+ * Checks if the filter may run on the current CPU
+ */
+bool box_filter_supported(box_filter_type_t type);
+
+/**
+ * Returns the fastest filter supported by the current CPU
+ */
+box_filter_type_t best_box_filter_type();
+
+box_filter_t get_box_filter(box_filter_type_t type);
+
+const char *box_filter_name(box_filter_type_t type);
+
+/**
+ * Compares the filter with the scalar one on random grids of assorted sizes, bands and channels
+ */
+bool verify_box_filter(box_filter_type_t type);
+
+void box_filter_scalar(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                       int row_to, box_filter_scratch_t *scratch);
+
+/**
+ * Portable kernel processing 8 bytes per 64-bit word, used when no vector instructions are available
+ */
+void box_filter_swar(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                     int row_to, box_filter_scratch_t *scratch);
+
+/**
+ * Computes rows [row_from, row_to) of the target as a sum of the (2 * radius + 1)^2 neighbourhood of each source cell
+ * divided by the neighbourhood size less one and truncated to the byte, so radius 1 gives the same result as other
+ * filters. Running sums of columns and of windows along rows keep the cost per cell independent of the radius.
+ * Column sums are kept in the scratch of the calling worker.
+ */
+void box_filter_running_sum(const Uint8 *source, Uint8 *target, int width, int height, int channels, int radius,
+                            int row_from, int row_to, box_filter_scratch_t *scratch);
+
+/**
+ * Compares the running sum with the scalar filter for radius 1 and with direct sums for larger radii
+ */
+bool verify_running_sum();
+
+#if defined(__x86_64__) || defined(__i386__)
+
+void box_filter_sse2(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                     int row_to, box_filter_scratch_t *scratch);
+
+void box_filter_avx2(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                     int row_to, box_filter_scratch_t *scratch);
+
+#endif
+
+#endif //SDL_TEST_BOX_FILTER_H
@@ -0,0 +1,116 @@
+#include "box_filter.h"
+
+/**
+ * Portable kernel doing SIMD within a 64-bit register. Same separable scheme as the x86 kernels: bytes of three rows
+ * are widened to 16-bit lanes and summed into the line buffer of the scratch, then three adjacent column sums give
+ * the cell value. A lane sums at most nine bytes, 2295 fits 16 bits, so lanes never carry into each other.
+ * Words are handled as little endian lanes, loads and stores convert them on big endian machines.
+ */
+
+#define SWAR_LOW_LANES 0x0000ffff0000ffffULL
+#define SWAR_BYTE_LANES 0x00ff00ff00ff00ffULL
+
+static inline Uint64
+load_bytes(const Uint8 *bytes) {
+    Uint64 word;
+    memcpy(&word, bytes, sizeof(word));
+    return SDL_SwapLE64(word);
+}
+
+static inline void
+store_bytes(Uint8 *bytes, Uint64 word) {
+    word = SDL_SwapLE64(word);
+    memcpy(bytes, &word, sizeof(word));
+}
+
+static inline Uint64
+swap_lanes(Uint64 word) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    word = (word >> 32) | (word << 32);
+    word = ((word >> 16) & SWAR_LOW_LANES) | ((word & SWAR_LOW_LANES) << 16);
+#endif
+    return word;
+}
+
+static inline Uint64
+load_lanes(const Uint16 *lanes) {
+    Uint64 word;
+    memcpy(&word, lanes, sizeof(word));
+    return swap_lanes(word);
+}
+
+static inline void
+store_lanes(Uint16 *lanes, Uint64 word) {
+    word = swap_lanes(word);
+    memcpy(lanes, &word, sizeof(word));
+}
+
+/**
+ * Spreads 4 low bytes of the word into 16-bit lanes
+ */
+static inline Uint64
+widen_bytes(Uint64 word) {
+    word &= 0xffffffffULL;
+    word = (word | (word << 16)) & SWAR_LOW_LANES;
+    return (word | (word << 8)) & SWAR_BYTE_LANES;
+}
+
+/**
+ * Gathers low bytes of 16-bit lanes into 4 low bytes of the word
+ */
+static inline Uint64
+narrow_lanes(Uint64 word) {
+    word &= SWAR_BYTE_LANES;
+    word = (word | (word >> 8)) & SWAR_LOW_LANES;
+    return (word | (word >> 16)) & 0xffffffffULL;
+}
+
+static void
+sum_columns_swar(const Uint8 *up, const Uint8 *middle, const Uint8 *down, Uint16 *columns, int row_size) {
+    int x = 0;
+    for (; x + 8 <= row_size; x += 8) {
+        Uint64 u = load_bytes(up + x);
+        Uint64 m = load_bytes(middle + x);
+        Uint64 d = load_bytes(down + x);
+        store_lanes(columns + x, widen_bytes(u) + widen_bytes(m) + widen_bytes(d));
+        store_lanes(columns + x + 4, widen_bytes(u >> 32) + widen_bytes(m >> 32) + widen_bytes(d >> 32));
+    }
+    for (; x < row_size; x++) {
+        columns[x] = (Uint16) (up[x] + middle[x] + down[x]);
+    }
+}
+
+static void
+sum_neighbours_swar(const Uint16 *columns, Uint8 *target, int row_size, int channels) {
+    const Uint16 *left = columns - channels;
+    const Uint16 *right = columns + channels;
+    int x = 0;
+    for (; x + 8 <= row_size; x += 8) {
+        Uint64 low = load_lanes(left + x) + load_lanes(columns + x) + load_lanes(right + x);
+        Uint64 high = load_lanes(left + x + 4) + load_lanes(columns + x + 4) + load_lanes(right + x + 4);
+        // bits shifted in from the upper lane are masked out, so the value is truncated as Uint16 to Uint8
+        store_bytes(target + x, narrow_lanes(low >> 3) | (narrow_lanes(high >> 3) << 32));
+    }
+    for (; x < row_size; x++) {
+        target[x] = (Uint8) ((left[x] + columns[x] + right[x]) >> 3);
+    }
+}
+
+void
+box_filter_swar(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from, int row_to,
+                box_filter_scratch_t *scratch) {
+    int row_size = width * channels;
+    Uint16 *padded_columns = scratch->columns;
+    memset(padded_columns, 0, channels * sizeof(Uint16));
+    memset(padded_columns + channels + row_size, 0, channels * sizeof(Uint16));
+    Uint16 *columns = padded_columns + channels;
+    const Uint8 *zero_row = scratch->zero_row;
+
+    for (int y = row_from; y < row_to; y++) {
+        const Uint8 *middle = source + (size_t) y * row_size;
+        const Uint8 *up = y > 0 ? middle - row_size : zero_row;
+        const Uint8 *down = y < height - 1 ? middle + row_size : zero_row;
+        sum_columns_swar(up, middle, down, columns, row_size);
+        sum_neighbours_swar(columns, target + (size_t) y * row_size, row_size, channels);
+    }
+}
@@ -0,0 +1,142 @@
+#include "box_filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/**
+ * Kernels are separable: first each column of the three rows is summed into the line buffer of the scratch (padded
+ * with a zero cell on both sides), then each three adjacent column sums give the cell value. Grid borders are handled
+ * by the padding and by replacing missing rows with the zero row, so inner loops have no branches.
+ * Rows are processed as plain byte sequences of row_size, with adjacent cells of the same channel being channels
+ * bytes apart.
+ */
+
+static inline void
+sum_columns_tail(const Uint8 *up, const Uint8 *middle, const Uint8 *down, Uint16 *columns, int from, int row_size) {
+    for (int x = from; x < row_size; x++) {
+        columns[x] = (Uint16) (up[x] + middle[x] + down[x]);
+    }
+}
+
+static inline void
+sum_neighbours_tail(const Uint16 *columns, Uint8 *target, int from, int row_size, int channels) {
+    for (int x = from; x < row_size; x++) {
+        target[x] = (Uint8) ((columns[x - channels] + columns[x] + columns[x + channels]) >> 3);
+    }
+}
+
+__attribute__((target("sse2"))) static void
+sum_columns_sse2(const Uint8 *up, const Uint8 *middle, const Uint8 *down, Uint16 *columns, int row_size) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= row_size; x += 16) {
+        __m128i u = _mm_loadu_si128((const __m128i *) (up + x));
+        __m128i m = _mm_loadu_si128((const __m128i *) (middle + x));
+        __m128i d = _mm_loadu_si128((const __m128i *) (down + x));
+
+        __m128i low = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(m, zero)),
+                                    _mm_unpacklo_epi8(d, zero));
+        __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(m, zero)),
+                                     _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i *) (columns + x), low);
+        _mm_storeu_si128((__m128i *) (columns + x + 8), high);
+    }
+    sum_columns_tail(up, middle, down, columns, x, row_size);
+}
+
+__attribute__((target("sse2"))) static void
+sum_neighbours_sse2(const Uint16 *columns, Uint8 *target, int row_size, int channels) {
+    const Uint16 *left = columns - channels;
+    const Uint16 *right = columns + channels;
+    const __m128i byte_mask = _mm_set1_epi16(0xff);
+    int x = 0;
+    for (; x + 16 <= row_size; x += 16) {
+        __m128i low = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *) (left + x)),
+                                                  _mm_loadu_si128((const __m128i *) (columns + x))),
+                                    _mm_loadu_si128((const __m128i *) (right + x)));
+        __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *) (left + x + 8)),
+                                                   _mm_loadu_si128((const __m128i *) (columns + x + 8))),
+                                     _mm_loadu_si128((const __m128i *) (right + x + 8)));
+        // truncating instead of saturating, same as assigning Uint16 to Uint8
+        low = _mm_and_si128(_mm_srli_epi16(low, 3), byte_mask);
+        high = _mm_and_si128(_mm_srli_epi16(high, 3), byte_mask);
+        _mm_storeu_si128((__m128i *) (target + x), _mm_packus_epi16(low, high));
+    }
+    sum_neighbours_tail(columns, target, x, row_size, channels);
+}
+
+__attribute__((target("avx2"))) static void
+sum_columns_avx2(const Uint8 *up, const Uint8 *middle, const Uint8 *down, Uint16 *columns, int row_size) {
+    int x = 0;
+    for (; x + 16 <= row_size; x += 16) {
+        __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (up + x)));
+        __m256i m = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (middle + x)));
+        __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (down + x)));
+        _mm256_storeu_si256((__m256i *) (columns + x), _mm256_add_epi16(_mm256_add_epi16(u, m), d));
+    }
+    sum_columns_tail(up, middle, down, columns, x, row_size);
+}
+
+__attribute__((target("avx2"))) static void
+sum_neighbours_avx2(const Uint16 *columns, Uint8 *target, int row_size, int channels) {
+    const Uint16 *left = columns - channels;
+    const Uint16 *right = columns + channels;
+    const __m256i byte_mask = _mm256_set1_epi16(0xff);
+    int x = 0;
+    for (; x + 32 <= row_size; x += 32) {
+        __m256i low = _mm256_add_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i *) (left + x)),
+                                                        _mm256_loadu_si256((const __m256i *) (columns + x))),
+                                       _mm256_loadu_si256((const __m256i *) (right + x)));
+        __m256i high = _mm256_add_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i *) (left + x + 16)),
+                                                         _mm256_loadu_si256((const __m256i *) (columns + x + 16))),
+                                        _mm256_loadu_si256((const __m256i *) (right + x + 16)));
+        low = _mm256_and_si256(_mm256_srli_epi16(low, 3), byte_mask);
+        high = _mm256_and_si256(_mm256_srli_epi16(high, 3), byte_mask);
+        // packing works within 128-bit lanes, so the quad words have to be put back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8);
+        _mm256_storeu_si256((__m256i *) (target + x), packed);
+    }
+    sum_neighbours_tail(columns, target, x, row_size, channels);
+}
+
+typedef void (*sum_columns_t)(const Uint8 *up, const Uint8 *middle, const Uint8 *down, Uint16 *columns,
+                              int row_size);
+
+typedef void (*sum_neighbours_t)(const Uint16 *columns, Uint8 *target, int row_size, int channels);
+
+static inline void
+box_filter_separable(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                     int row_to, box_filter_scratch_t *scratch, sum_columns_t sum_columns,
+                     sum_neighbours_t sum_neighbours) {
+    int row_size = width * channels;
+    Uint16 *padded_columns = scratch->columns;
+    memset(padded_columns, 0, channels * sizeof(Uint16));
+    memset(padded_columns + channels + row_size, 0, channels * sizeof(Uint16));
+    Uint16 *columns = padded_columns + channels;
+    const Uint8 *zero_row = scratch->zero_row;
+
+    for (int y = row_from; y < row_to; y++) {
+        const Uint8 *middle = source + (size_t) y * row_size;
+        const Uint8 *up = y > 0 ? middle - row_size : zero_row;
+        const Uint8 *down = y < height - 1 ? middle + row_size : zero_row;
+        sum_columns(up, middle, down, columns, row_size);
+        sum_neighbours(columns, target + (size_t) y * row_size, row_size, channels);
+    }
+}
+
+void
+box_filter_sse2(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                int row_to, box_filter_scratch_t *scratch) {
+    box_filter_separable(source, target, width, height, channels, row_from, row_to, scratch, sum_columns_sse2,
+                         sum_neighbours_sse2);
+}
+
+void
+box_filter_avx2(const Uint8 *source, Uint8 *target, int width, int height, int channels, int row_from,
+                int row_to, box_filter_scratch_t *scratch) {
+    box_filter_separable(source, target, width, height, channels, row_from, row_to, scratch, sum_columns_avx2,
+                         sum_neighbours_avx2);
+}
+
+#endif
@@ -0,0 +1,369 @@
+#include "domain.h"
+#include "simulation.h"
+#include "../opengl/sdl_ext.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DOMAIN_ALIGNMENT 64
+#define DOMAIN_ALIGN(size) (((size) + DOMAIN_ALIGNMENT - 1) & ~(size_t) (DOMAIN_ALIGNMENT - 1))
+/**
+ * period of checks that the other ranks are alive while waiting at the barrier
+ */
+#define DOMAIN_POLL_MS 100
+
+extern char **environ;
+
+/**
+ * Head of the shared memory segment, followed by the frame and halo slots
+ */
+struct domain_shared {
+    /**
+     * ranks arrived at the current barrier
+     */
+    SDL_atomic_t waiting;
+    /**
+     * ranks sleep on it with a futex until the last rank to arrive increments it
+     */
+    SDL_atomic_t barriers_passed;
+    /**
+     * set when a rank has exited out of turn, the other ranks stop waiting
+     */
+    SDL_atomic_t failed;
+    pid_t owner;
+    char name[DOMAIN_NAME_SIZE];
+    domain_config_t config;
+    /**
+     * set by rank 0 before the step barrier to stop other ranks
+     */
+    int stopping;
+};
+
+static size_t
+get_frame_size(const domain_config_t *config) {
+    return DOMAIN_ALIGN((size_t) config->width * config->height * CHANNELS_NUMBER);
+}
+
+static size_t
+get_slot_size(const domain_config_t *config) {
+    return DOMAIN_ALIGN((size_t) config->radius * config->width * CHANNELS_NUMBER);
+}
+
+static size_t
+get_shared_size(const domain_config_t *config) {
+    return DOMAIN_ALIGN(sizeof(domain_shared_t)) + get_frame_size(config) +
+           4 * (size_t) config->ranks * get_slot_size(config);
+}
+
+static domain_shared_t *
+map_shared(int fd, size_t size) {
+    void *shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (shared == MAP_FAILED) {
+        SDL_Die("Failed to map domain shared memory of %zu bytes", size);
+    }
+    close(fd);
+    return shared;
+}
+
+static long
+futex(SDL_atomic_t *word, int operation, int value, const struct timespec *timeout) {
+    return syscall(SYS_futex, &word->value, operation, value, timeout, NULL, 0);
+}
+
+/**
+ * Rank 0 reaps exited ranks without blocking, other ranks check they were not reparented after rank 0 exited
+ */
+static bool
+ranks_alive(domain_t *domain) {
+    if (domain->rank != 0) {
+        return getppid() == domain->shared->owner;
+    }
+    bool alive = true;
+    for (int rank = 1; rank < domain->config.ranks; rank++) {
+        if (domain->processes[rank] > 0 && waitpid(domain->processes[rank], NULL, WNOHANG) > 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Domain process of rank %d exited", rank);
+            domain->processes[rank] = 0;
+            alive = false;
+        }
+    }
+    return alive;
+}
+
+/**
+ * Waits for all ranks, returns false when a rank has exited instead. The shared memory is unlinked then, rank 0 may
+ * not have done it yet.
+ */
+static bool
+wait_barrier(domain_t *domain) {
+    domain_shared_t *shared = domain->shared;
+    int barriers_passed = SDL_AtomicGet(&shared->barriers_passed);
+    if (SDL_AtomicAdd(&shared->waiting, 1) == domain->config.ranks - 1) {
+        SDL_AtomicSet(&shared->waiting, 0);
+        SDL_AtomicAdd(&shared->barriers_passed, 1);
+        futex(&shared->barriers_passed, FUTEX_WAKE, INT_MAX, NULL);
+        return true;
+    }
+    const struct timespec timeout = {0, DOMAIN_POLL_MS * 1000000L};
+    while (SDL_AtomicGet(&shared->barriers_passed) == barriers_passed) {
+        if (SDL_AtomicGet(&shared->failed)) {
+            shm_unlink(shared->name);
+            return false;
+        }
+        if (futex(&shared->barriers_passed, FUTEX_WAIT, barriers_passed, &timeout) != 0 && errno == ETIMEDOUT &&
+            !ranks_alive(domain)) {
+            SDL_AtomicSet(&shared->failed, 1);
+            futex(&shared->barriers_passed, FUTEX_WAKE, INT_MAX, NULL);
+        }
+    }
+    return true;
+}
+
+/**
+ * Waits for all ranks while stepping, there is no way to continue when a rank has exited
+ */
+static void
+step_barrier(domain_t *domain) {
+    if (!wait_barrier(domain)) {
+        SDL_Die("Domain process of rank %d stopped, a process of the domain has exited", domain->rank);
+    }
+}
+
+/**
+ * Stops the ranks started by rank 0 and waits for them, exited ranks have process 0
+ */
+static void
+stop_processes(pid_t *processes, int ranks) {
+    for (int rank = 1; rank < ranks; rank++) {
+        if (processes[rank] > 0) {
+            kill(processes[rank], SIGTERM);
+            waitpid(processes[rank], NULL, 0);
+            processes[rank] = 0;
+        }
+    }
+}
+
+/**
+ * Sets up the band of the rank and fills it from the seed
+ */
+static domain_t *
+init_domain(domain_shared_t *shared, size_t shared_size, int rank) {
+    domain_t *domain = calloc(1, sizeof(domain_t));
+    SDL_ALLOC_CHECK(domain)
+    domain->config = shared->config;
+    domain->rank = rank;
+    domain->shared = shared;
+    domain->shared_size = shared_size;
+
+    const domain_config_t *config = &domain->config;
+    int halo = config->radius;
+    domain->row_from = (int) ((Sint64) config->height * rank / config->ranks);
+    domain->row_to = (int) ((Sint64) config->height * (rank + 1) / config->ranks);
+    domain->band = create_grid(config->width, domain->row_to - domain->row_from + 2 * halo, config->layout);
+    if (config->radius == 1) {
+        domain->box_filter = get_box_filter(config->box_filter_type);
+    }
+    domain->box_filter_scratch = create_grid_filter_scratch(domain->band);
+
+    Uint8 *cells = (Uint8 *) shared + DOMAIN_ALIGN(sizeof(domain_shared_t));
+    domain->frame = create_grid_view(config->width, config->height, config->layout, cells);
+    cells += get_frame_size(config);
+    int slots_number = 4 * config->ranks;
+    domain->halo_slots = calloc(slots_number, sizeof(grid_t *));
+    SDL_ALLOC_CHECK(domain->halo_slots)
+    for (int i = 0; i < slots_number; i++) {
+        domain->halo_slots[i] = create_grid_view(config->width, halo, config->layout, cells);
+        cells += get_slot_size(config);
+    }
+
+    // the frame takes the grid stream at global offsets, so the band is the same as in a single process
+    size_t row_size = (size_t) config->width * domain->frame->cell_stride;
+    randomize_grid(domain->frame, config->seed, domain->row_from * row_size, domain->row_to * row_size);
+    copy_grid_rows(domain->frame, domain->row_from, domain->band, halo, domain->row_to - domain->row_from);
+    return domain;
+}
+
+domain_t *
+create_domain(const domain_config_t *config) {
+    if (config->ranks < 2) {
+        SDL_Die("Domain needs at least 2 processes");
+    }
+    if (config->height / config->ranks < config->radius) {
+        SDL_Die("Bands of %d rows for %d processes are thinner than radius %d", config->height / config->ranks,
+                config->ranks, config->radius);
+    }
+    char name[DOMAIN_NAME_SIZE];
+    snprintf(name, sizeof(name), "/sdl_test_domain_%d", (int) getpid());
+    size_t shared_size = get_shared_size(config);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t) shared_size) != 0) {
+        if (fd >= 0) {
+            shm_unlink(name);
+        }
+        SDL_Die("Failed to create domain shared memory %s of %zu bytes", name, shared_size);
+    }
+    domain_shared_t *shared = map_shared(fd, shared_size);
+    shared->config = *config;
+    shared->owner = getpid();
+    snprintf(shared->name, sizeof(shared->name), "%s", name);
+
+    pid_t *processes = calloc(config->ranks, sizeof(pid_t));
+    SDL_ALLOC_CHECK(processes)
+    for (int rank = 1; rank < config->ranks; rank++) {
+        char rank_argument[16];
+        snprintf(rank_argument, sizeof(rank_argument), "%d", rank);
+        char *argv[] = {"sdl_test", "--domain-rank", rank_argument, "--domain-name", name, NULL};
+        if (posix_spawn(&processes[rank], "/proc/self/exe", NULL, NULL, argv, environ) != 0) {
+            processes[rank] = 0;
+            stop_processes(processes, rank);
+            shm_unlink(name);
+            SDL_Die("Failed to start domain process of rank %d", rank);
+        }
+    }
+
+    domain_t *domain = init_domain(shared, shared_size, 0);
+    domain->processes = processes;
+    if (!wait_barrier(domain)) {
+        stop_processes(processes, config->ranks);
+        SDL_Die("Domain processes failed to start");
+    }
+    // all ranks are attached, the segment lives until the last of them unmaps it
+    shm_unlink(name);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Domain of %d processes, %d rows per band, %zu bytes shared",
+                config->ranks, config->height / config->ranks, shared_size);
+    return domain;
+}
+
+int
+run_domain_rank(const char *name, int rank) {
+    // ranks are started by the main thread of rank 0, so they get the signal when rank 0 exits
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    int fd = shm_open(name, O_RDWR, 0);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        SDL_Die("Failed to open domain shared memory %s", name);
+    }
+    domain_shared_t *shared = map_shared(fd, (size_t) status.st_size);
+    if (getppid() != shared->owner) {
+        // rank 0 exited before the signal was requested
+        shm_unlink(name);
+        SDL_Die("Domain process of rank 0 has exited");
+    }
+    domain_t *domain = init_domain(shared, (size_t) status.st_size, rank);
+    step_barrier(domain);
+    while (step_domain(domain)) {
+    }
+    destroy_domain(&domain);
+    return 0;
+}
+
+static void
+add_band_disturbance(domain_t *domain) {
+    const domain_config_t *config = &domain->config;
+    for (int i = 0; i < DISTURBANCES_PER_STEP; i++) {
+        disturbance_t disturbance;
+        get_disturbance(config->seed, domain->step, i, config->width, config->height, &disturbance);
+        if (disturbance.y < domain->row_from || disturbance.y >= domain->row_to) {
+            continue;
+        }
+        int y = disturbance.y - domain->row_from + config->radius;
+        for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+            *grid_cell(domain->band, channel, disturbance.x, y) = disturbance.cell[channel];
+        }
+    }
+}
+
+/**
+ * Slots alternate between generations, so a rank may publish the next generation while its neighbours still read
+ * the previous one
+ */
+static void
+exchange_halos(domain_t *domain) {
+    int ranks = domain->config.ranks;
+    int halo = domain->config.radius;
+    int rows = domain->row_to - domain->row_from;
+    grid_t **slots = domain->halo_slots + (domain->generation & 1) * 2 * ranks;
+    if (domain->rank > 0) {
+        copy_grid_rows(domain->band, halo, slots[2 * domain->rank], 0, halo);
+    }
+    if (domain->rank < ranks - 1) {
+        copy_grid_rows(domain->band, rows, slots[2 * domain->rank + 1], 0, halo);
+    }
+    step_barrier(domain);
+    if (domain->rank > 0) {
+        copy_grid_rows(slots[2 * (domain->rank - 1) + 1], 0, domain->band, 0, halo);
+    }
+    if (domain->rank < ranks - 1) {
+        copy_grid_rows(slots[2 * (domain->rank + 1)], 0, domain->band, halo + rows, halo);
+    }
+}
+
+bool
+step_domain(domain_t *domain) {
+    // ranks above 0 wait here for rank 0 to step or to stop
+    step_barrier(domain);
+    if (domain->shared->stopping) {
+        return false;
+    }
+    add_band_disturbance(domain);
+    int halo = domain->config.radius;
+    int rows = domain->row_to - domain->row_from;
+    for (int generation = 0; generation < domain->config.generations; generation++) {
+        // halo rows of the global grid edges stay zero, as the padding of a single grid
+        exchange_halos(domain);
+        if (domain->box_filter != NULL) {
+            step_grid_rows(domain->band, domain->box_filter, domain->box_filter_scratch, halo, halo + rows);
+        } else {
+            step_grid_rows_radius(domain->band, domain->config.radius, domain->box_filter_scratch, halo, halo + rows);
+        }
+        swap_grid_buffers(domain->band);
+        domain->generation++;
+    }
+    copy_grid_rows(domain->band, halo, domain->frame, domain->row_from, rows);
+    step_barrier(domain);
+    domain->step++;
+    return true;
+}
+
+void
+destroy_domain(domain_t **pp_domain) {
+    domain_t *domain = *pp_domain;
+    if (domain == NULL) {
+        return;
+    }
+    if (domain->rank == 0) {
+        domain->shared->stopping = 1;
+        // after a failure this runs from exit(), the remaining ranks are stopped without the barrier
+        if (!SDL_AtomicGet(&domain->shared->failed) && wait_barrier(domain)) {
+            for (int rank = 1; rank < domain->config.ranks; rank++) {
+                int status;
+                if (waitpid(domain->processes[rank], &status, 0) < 0 || !WIFEXITED(status) ||
+                    WEXITSTATUS(status) != 0) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Domain process of rank %d failed", rank);
+                }
+            }
+        } else {
+            stop_processes(domain->processes, domain->config.ranks);
+        }
+        free(domain->processes);
+    }
+    for (int i = 0; i < 4 * domain->config.ranks; i++) {
+        destroy_grid(&domain->halo_slots[i]);
+    }
+    free(domain->halo_slots);
+    destroy_grid(&domain->frame);
+    destroy_grid(&domain->band);
+    destroy_box_filter_scratch(&domain->box_filter_scratch);
+    munmap(domain->shared, domain->shared_size);
+    free(domain);
+    *pp_domain = NULL;
+}
@@ -0,0 +1,85 @@
+#ifndef SDL_TEST_DOMAIN_H
+#define SDL_TEST_DOMAIN_H
+
+#include "grid.h"
+#include "box_filter.h"
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define DOMAIN_NAME_SIZE 64
+
+typedef struct domain_config {
+    int width;
+    int height;
+    grid_layout_t layout;
+    box_filter_type_t box_filter_type;
+    int radius;
+    int generations;
+    Uint64 seed;
+    /**
+     * number of processes, each of them steps a band of rows
+     */
+    int ranks;
+} domain_config_t;
+
+typedef struct domain_shared domain_shared_t;
+
+/**
+ * Simulation grid decomposed into horizontal bands stepped by separate processes. Rank 0 is the process which
+ * creates the domain, it spawns the other ranks as sdl_test processes attached to a POSIX shared memory segment.
+ * Each rank keeps its band in a private grid with radius halo rows above and below. Before every generation ranks
+ * publish their edge rows to shared slots and take the neighbour ones into the halos, in lock step on a process
+ * shared barrier. After a step every rank copies its band into the shared frame, which rank 0 presents.
+ * Every step gives the same grid as a single process simulation of the same seed.
+ * Ranks waiting at the barrier check the others periodically: when any rank exits out of turn the remaining ones
+ * exit with an error, and ranks above 0 are killed when rank 0 exits.
+ */
+typedef struct domain {
+    domain_config_t config;
+    int rank;
+    int row_from;
+    int row_to;
+    grid_t *band;
+    box_filter_t box_filter;
+    box_filter_scratch_t *box_filter_scratch;
+    /**
+     * full grid shared by all ranks, up to date after every step
+     */
+    grid_t *frame;
+    /**
+     * edge rows published by ranks, [generation parity][rank][0 - top, 1 - bottom]
+     */
+    grid_t **halo_slots;
+    domain_shared_t *shared;
+    size_t shared_size;
+    Uint64 step;
+    Uint64 generation;
+    /**
+     * processes of other ranks, rank 0 only
+     */
+    pid_t *processes;
+} domain_t;
+
+/**
+ * Creates the domain as rank 0 and starts the other ranks, returns when all bands are initialized from the seed
+ */
+domain_t *create_domain(const domain_config_t *config);
+
+/**
+ * Body of ranks above 0 started by create_domain(): steps with rank 0 until it destroys the domain, returns the exit
+ * code
+ */
+int run_domain_rank(const char *name, int rank);
+
+/**
+ * Adds disturbance and advances the domain by configured number of generations, returns false for ranks above 0
+ * when rank 0 stops the domain
+ */
+bool step_domain(domain_t *domain);
+
+/**
+ * Stops other ranks when called by rank 0 and unmaps the shared memory
+ */
+void destroy_domain(domain_t **pp_domain);
+
+#endif //SDL_TEST_DOMAIN_H
@@ -0,0 +1,208 @@
+#include "frame_recorder.h"
+#include "../opengl/sdl_ext.h"
+
+static const char *FRAME_FORMAT_NAMES[FRAME_FORMAT_LAST_TYPE] = {"raw rgb24", "y4m"};
+static const char Y4M_FRAME_HEADER[] = "FRAME\n";
+
+const char *
+frame_format_name(frame_format_t format) {
+    return FRAME_FORMAT_NAMES[format];
+}
+
+static frame_format_t
+get_frame_format(const char *path) {
+    size_t length = SDL_strlen(path);
+    if (length >= 4 && SDL_strcasecmp(path + length - 4, ".y4m") == 0) {
+        return FRAME_FORMAT_Y4M;
+    }
+    return FRAME_FORMAT_RAW;
+}
+
+/**
+ * Integer full range BT.601 conversion with 8 fractional bits
+ */
+static void
+convert_to_yuv(const Uint8 *red, const Uint8 *green, const Uint8 *blue, int cell_stride, Uint8 *y_plane,
+               Uint8 *u_plane, Uint8 *v_plane, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int r = red[i * cell_stride];
+        int g = green[i * cell_stride];
+        int b = blue[i * cell_stride];
+        y_plane[i] = (Uint8) ((77 * r + 150 * g + 29 * b + 128) >> 8);
+        // pure blue and red round up to 256
+        u_plane[i] = (Uint8) SDL_min(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128, 255);
+        v_plane[i] = (Uint8) SDL_min(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128, 255);
+    }
+}
+
+/**
+ * Converts the frame of the slot to the output format, returns the data to write
+ */
+static const Uint8 *
+convert_frame(frame_recorder_t *recorder, const Uint8 *frame, size_t *size) {
+    size_t count = (size_t) recorder->width * recorder->height;
+    const Uint8 *red = frame;
+    const Uint8 *green = recorder->layout == GRID_LAYOUT_INTERLEAVED ? frame + 1 : frame + count;
+    const Uint8 *blue = recorder->layout == GRID_LAYOUT_INTERLEAVED ? frame + 2 : frame + 2 * count;
+    int cell_stride = recorder->layout == GRID_LAYOUT_INTERLEAVED ? CHANNELS_NUMBER : 1;
+
+    *size = recorder->output_size;
+    Uint8 *pixels = recorder->output + recorder->header_size;
+    if (recorder->format == FRAME_FORMAT_Y4M) {
+        convert_to_yuv(red, green, blue, cell_stride, pixels, pixels + count, pixels + 2 * count, count);
+    } else if (recorder->layout == GRID_LAYOUT_INTERLEAVED) {
+        // already rgb24
+        return frame;
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            pixels[i * CHANNELS_NUMBER + CHANNEL_RED] = red[i];
+            pixels[i * CHANNELS_NUMBER + CHANNEL_GREEN] = green[i];
+            pixels[i * CHANNELS_NUMBER + CHANNEL_BLUE] = blue[i];
+        }
+    }
+    return recorder->output;
+}
+
+static int
+writer_thread(void *data) {
+    frame_recorder_t *recorder = data;
+    SDL_LockMutex(recorder->mutex);
+    while (true) {
+        while (!recorder->stopping && recorder->slots_used == 0) {
+            SDL_CondWait(recorder->frame_ready, recorder->mutex);
+        }
+        if (recorder->slots_used == 0) {
+            break;
+        }
+        const Uint8 *frame = recorder->slots[recorder->first_slot];
+        SDL_UnlockMutex(recorder->mutex);
+
+        // the producer does not touch queued slots, so the frame is converted and written without the lock
+        if (!recorder->write_failed) {
+            size_t size;
+            const Uint8 *output = convert_frame(recorder, frame, &size);
+            if (fwrite(output, 1, size, recorder->file) != size) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write recorded frame, recording stopped");
+                recorder->write_failed = true;
+            }
+        }
+
+        SDL_LockMutex(recorder->mutex);
+        if (!recorder->write_failed) {
+            recorder->frames_written++;
+        }
+        recorder->first_slot = (recorder->first_slot + 1) % recorder->slots_number;
+        recorder->slots_used--;
+    }
+    SDL_UnlockMutex(recorder->mutex);
+    return 0;
+}
+
+frame_recorder_t *
+create_frame_recorder(const char *path, const grid_t *grid, int frame_rate) {
+    frame_recorder_t *recorder = calloc(1, sizeof(frame_recorder_t));
+    SDL_ALLOC_CHECK(recorder)
+    recorder->format = get_frame_format(path);
+    recorder->width = grid->width;
+    recorder->height = grid->height;
+    recorder->layout = grid->layout;
+    recorder->frame_size = (size_t) grid->width * grid->height * CHANNELS_NUMBER;
+    recorder->slots_number = (unsigned int) SDL_clamp(FRAME_RECORDER_RING_SIZE / recorder->frame_size, 1,
+                                                      FRAME_RECORDER_MAX_SLOTS);
+    recorder->slots = calloc(recorder->slots_number, sizeof(Uint8 *));
+    SDL_ALLOC_CHECK(recorder->slots)
+    for (unsigned int i = 0; i < recorder->slots_number; i++) {
+        recorder->slots[i] = malloc(recorder->frame_size);
+        SDL_ALLOC_CHECK(recorder->slots[i])
+    }
+    recorder->header_size = recorder->format == FRAME_FORMAT_Y4M ? sizeof(Y4M_FRAME_HEADER) - 1 : 0;
+    recorder->output_size = recorder->header_size + recorder->frame_size;
+    recorder->output = malloc(recorder->output_size);
+    SDL_ALLOC_CHECK(recorder->output)
+    SDL_memcpy(recorder->output, Y4M_FRAME_HEADER, recorder->header_size);
+
+    recorder->file = fopen(path, "wb");
+    if (recorder->file == NULL) {
+        SDL_Die("Failed to open %s for recording", path);
+    }
+    // frames are written whole, the buffer only merges headers and small frames into large writes
+    setvbuf(recorder->file, NULL, _IOFBF, FRAME_RECORDER_FILE_BUFFER_SIZE);
+    if (recorder->format == FRAME_FORMAT_Y4M) {
+        fprintf(recorder->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", grid->width, grid->height,
+                frame_rate);
+    }
+
+    recorder->mutex = SDL_CreateMutex();
+    recorder->frame_ready = SDL_CreateCond();
+    if (recorder->mutex == NULL || recorder->frame_ready == NULL) {
+        SDL_Die("Failed to create frame recorder synchronization: %s", SDL_GetError());
+    }
+    recorder->thread = SDL_CreateThread(writer_thread, "frame writer", recorder);
+    if (recorder->thread == NULL) {
+        SDL_Die("Failed to create frame writer thread: %s", SDL_GetError());
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Recording %dx%d %s frames to %s through %u slots", grid->width,
+                grid->height, frame_format_name(recorder->format), path, recorder->slots_number);
+    return recorder;
+}
+
+bool
+record_frame(frame_recorder_t *recorder, const grid_t *grid) {
+    SDL_LockMutex(recorder->mutex);
+    bool full = recorder->slots_used == recorder->slots_number;
+    unsigned int slot = (recorder->first_slot + recorder->slots_used) % recorder->slots_number;
+    unsigned int frames_dropped = full ? ++recorder->frames_dropped : recorder->frames_dropped;
+    SDL_UnlockMutex(recorder->mutex);
+    if (full) {
+        // reported at powers of two, so a writer which stays behind does not flood the log
+        if ((frames_dropped & (frames_dropped - 1)) == 0) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Frame writer is behind, frames dropped so far: %u",
+                        frames_dropped);
+        }
+        return false;
+    }
+
+    // the free slot belongs to the producer until it is queued
+    if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+        SDL_memcpy(recorder->slots[slot], grid->current[0], recorder->frame_size);
+    } else {
+        size_t plane_size = recorder->frame_size / CHANNELS_NUMBER;
+        for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+            SDL_memcpy(recorder->slots[slot] + channel * plane_size, grid->current[channel], plane_size);
+        }
+    }
+
+    SDL_LockMutex(recorder->mutex);
+    recorder->slots_used++;
+    SDL_CondSignal(recorder->frame_ready);
+    SDL_UnlockMutex(recorder->mutex);
+    return true;
+}
+
+void
+destroy_frame_recorder(frame_recorder_t **pp_recorder) {
+    frame_recorder_t *recorder = *pp_recorder;
+    if (recorder == NULL) {
+        return;
+    }
+    SDL_LockMutex(recorder->mutex);
+    recorder->stopping = true;
+    SDL_CondSignal(recorder->frame_ready);
+    SDL_UnlockMutex(recorder->mutex);
+    SDL_WaitThread(recorder->thread, NULL);
+
+    if (fclose(recorder->file) != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to close recording");
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Recorded %u frames, dropped %u", recorder->frames_written,
+                recorder->frames_dropped);
+    SDL_DestroyCond(recorder->frame_ready);
+    SDL_DestroyMutex(recorder->mutex);
+    free(recorder->output);
+    for (unsigned int i = 0; i < recorder->slots_number; i++) {
+        free(recorder->slots[i]);
+    }
+    free(recorder->slots);
+    free(recorder);
+    *pp_recorder = NULL;
+}
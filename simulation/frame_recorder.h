@@ -0,0 +1,80 @@
+#ifndef SDL_TEST_FRAME_RECORDER_H
+#define SDL_TEST_FRAME_RECORDER_H
+
+#include "grid.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * Bytes of frames the ring may hold and the most slots it gets, frames larger than the ring still get a single slot
+ */
+#define FRAME_RECORDER_RING_SIZE (256 * 1024 * 1024)
+#define FRAME_RECORDER_MAX_SLOTS 8
+#define FRAME_RECORDER_FILE_BUFFER_SIZE (4 * 1024 * 1024)
+
+typedef enum {
+    /**
+     * headerless rgb24 frames
+     */
+    FRAME_FORMAT_RAW = 0,
+    /**
+     * YUV4MPEG2 stream with full range BT.601 4:4:4 frames
+     */
+    FRAME_FORMAT_Y4M,
+    FRAME_FORMAT_LAST_TYPE
+} frame_format_t;
+
+/**
+ * Records grid frames to a file without blocking the simulation on I/O. Frames are copied as they are laid out in
+ * the grid into a ring of preallocated slots, a writer thread converts them to the output format and writes them
+ * sequentially. The number of slots is derived from the frame size, so the ring stays within
+ * FRAME_RECORDER_RING_SIZE. When all slots are waiting for the writer, new frames are dropped, counted and reported
+ * with a warning.
+ */
+typedef struct frame_recorder {
+    FILE *file;
+    frame_format_t format;
+    int width;
+    int height;
+    grid_layout_t layout;
+    size_t frame_size;
+    unsigned int slots_number;
+    Uint8 **slots;
+    /**
+     * converted frame of the writer thread, prefixed with the frame header of the format
+     */
+    Uint8 *output;
+    size_t output_size;
+    size_t header_size;
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *frame_ready;
+    /**
+     * slot of the oldest frame waiting for the writer and number of waiting frames
+     */
+    unsigned int first_slot;
+    unsigned int slots_used;
+    bool stopping;
+    bool write_failed;
+    unsigned int frames_written;
+    unsigned int frames_dropped;
+} frame_recorder_t;
+
+/**
+ * Opens the file for frames of the grid, the format is Y4M for files with .y4m extension and raw otherwise
+ */
+frame_recorder_t *create_frame_recorder(const char *path, const grid_t *grid, int frame_rate);
+
+/**
+ * Queues the current buffers of the grid for writing, returns false if the frame was dropped
+ */
+bool record_frame(frame_recorder_t *recorder, const grid_t *grid);
+
+/**
+ * Writes all queued frames and closes the file
+ */
+void destroy_frame_recorder(frame_recorder_t **pp_recorder);
+
+const char *frame_format_name(frame_format_t format);
+
+#endif //SDL_TEST_FRAME_RECORDER_H
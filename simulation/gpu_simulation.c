@@ -0,0 +1,161 @@
+#include "gpu_simulation.h"
+#include "simulation.h"
+
+static void
+check_interleaved_grid(const gpu_simulation_t *simulation, const grid_t *grid) {
+    if (grid->layout != GRID_LAYOUT_INTERLEAVED) {
+        SDL_Die("GPU simulation works with %s grids only", grid_layout_name(GRID_LAYOUT_INTERLEAVED));
+    }
+    if (grid->width != simulation->width || grid->height != simulation->height) {
+        SDL_Die("Grid %dx%d does not match GPU simulation %dx%d", grid->width, grid->height, simulation->width,
+                simulation->height);
+    }
+}
+
+static void
+init_cells_texture(gpu_simulation_t *simulation, int index, const Uint8 *cells) {
+    glGenTextures(1, &simulation->textures[index]);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, simulation->textures[index]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, simulation->width, simulation->height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                 cells);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GL_CHECK_ERROR;
+
+    glGenFramebuffers(1, &simulation->frame_buffers[index]);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, simulation->frame_buffers[index]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, simulation->textures[index], 0);
+    if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER)) {
+        SDL_Die("Frame buffer incomplete");
+    }
+    gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, 0);
+    GL_CHECK_ERROR;
+}
+
+static void
+init_screen_quad(gpu_simulation_t *simulation) {
+    glGenVertexArrays(1, &simulation->vertex_array);
+    gl_bind_vertex_array(simulation->vertex_array);
+
+    glGenBuffers(1, &simulation->vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, simulation->vertex_buffer);
+
+    const float screen_data[] = {
+            // positions   // texture coords
+            -1.0f, 1.0f, 0.0f, 1.0f,
+            -1.0f, -1.0f, 0.0f, 0.0f,
+            1.0f, -1.0f, 1.0f, 0.0f,
+
+            -1.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, -1.0f, 1.0f, 0.0f,
+            1.0f, 1.0f, 1.0f, 1.0f
+    };
+    glBufferData(GL_ARRAY_BUFFER, sizeof(screen_data), screen_data, GL_STATIC_DRAW);
+
+    // vertex positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
+
+    // texture coords
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
+
+    gl_bind_vertex_array(0);
+    GL_CHECK_ERROR;
+}
+
+gpu_simulation_t *
+create_gpu_simulation(const grid_t *grid, int generations, Uint64 seed) {
+    gpu_simulation_t *simulation = calloc(1, sizeof(gpu_simulation_t));
+    SDL_ALLOC_CHECK(simulation)
+    simulation->width = grid->width;
+    simulation->height = grid->height;
+    simulation->generations = generations;
+    simulation->seed = seed;
+    check_interleaved_grid(simulation, grid);
+
+    // rows of RGB cells are not 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    init_cells_texture(simulation, 0, grid->current[0]);
+    init_cells_texture(simulation, 1, NULL);
+    init_screen_quad(simulation);
+
+    attach_shader(&simulation->step_shader,
+                  submit_shader("shaders/scene_screen_vertex.glsl", "shaders/diffusion_step_fragment.glsl"));
+    attach_shader(&simulation->present_shader,
+                  submit_shader("shaders/scene_screen_vertex.glsl", "shaders/diffusion_present_fragment.glsl"));
+    return simulation;
+}
+
+void
+add_gpu_disturbance(gpu_simulation_t *simulation) {
+    // the uploads go to the texture of the active unit
+    gl_active_texture(GL_TEXTURE0);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, simulation->textures[simulation->current]);
+    for (int i = 0; i < DISTURBANCES_PER_STEP; i++) {
+        disturbance_t disturbance;
+        get_disturbance(simulation->seed, simulation->step, i, simulation->width, simulation->height, &disturbance);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, disturbance.x, disturbance.y, 1, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                        disturbance.cell);
+    }
+    simulation->step++;
+    GL_CHECK_ERROR;
+}
+
+void
+step_gpu_simulation(gpu_simulation_t *simulation) {
+    add_gpu_disturbance(simulation);
+
+    shader_use(simulation->step_shader);
+    gl_bind_vertex_array(simulation->vertex_array);
+    glViewport(0, 0, simulation->width, simulation->height);
+    for (int generation = 0; generation < simulation->generations; generation++) {
+        int next = 1 - simulation->current;
+        gl_bind_framebuffer(GL_FRAMEBUFFER, simulation->frame_buffers[next]);
+        gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, simulation->textures[simulation->current]);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        simulation->current = next;
+    }
+    gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    GL_CHECK_ERROR;
+}
+
+void
+present_gpu_simulation(gpu_simulation_t *simulation, int viewport_width, int viewport_height) {
+    gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, viewport_width, viewport_height);
+    shader_use(simulation->present_shader);
+    gl_bind_vertex_array(simulation->vertex_array);
+    gl_bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, simulation->textures[simulation->current]);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    GL_CHECK_ERROR;
+}
+
+void
+read_gpu_simulation(gpu_simulation_t *simulation, grid_t *grid) {
+    check_interleaved_grid(simulation, grid);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, simulation->frame_buffers[simulation->current]);
+    glReadPixels(0, 0, simulation->width, simulation->height, GL_RGB, GL_UNSIGNED_BYTE, grid->current[0]);
+    gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    GL_CHECK_ERROR;
+}
+
+void
+destroy_gpu_simulation(gpu_simulation_t **pp_simulation) {
+    gpu_simulation_t *simulation = *pp_simulation;
+    if (simulation == NULL) {
+        return;
+    }
+    detach_shader(&simulation->step_shader);
+    detach_shader(&simulation->present_shader);
+    glDeleteBuffers(1, &simulation->vertex_buffer);
+    gl_delete_vertex_arrays(1, &simulation->vertex_array);
+    gl_delete_framebuffers(2, simulation->frame_buffers);
+    gl_delete_textures(2, simulation->textures);
+    free(simulation);
+    *pp_simulation = NULL;
+}
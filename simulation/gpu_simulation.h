@@ -0,0 +1,61 @@
+#ifndef SDL_TEST_GPU_SIMULATION_H
+#define SDL_TEST_GPU_SIMULATION_H
+
+#include "grid.h"
+#include "../opengl/shader.h"
+
+/**
+ * Simulation stepped by a fragment shader on the GPU. Channels live in a pair of RGB8 textures attached to frame
+ * buffers, each generation renders the box filter of the current texture into the other one and swaps them, so
+ * the grid never leaves the GPU. Texture row y is grid row y, only disturbances are uploaded.
+ * Requires a current OpenGL context.
+ */
+typedef struct gpu_simulation {
+    int width;
+    int height;
+    int generations;
+    Uint64 seed;
+    /**
+     * steps taken, counter of disturbances
+     */
+    Uint64 step;
+    unsigned int textures[2];
+    unsigned int frame_buffers[2];
+    /**
+     * index of the texture with the current generation
+     */
+    int current;
+    unsigned int vertex_array;
+    unsigned int vertex_buffer;
+    shader_t *step_shader;
+    shader_t *present_shader;
+} gpu_simulation_t;
+
+/**
+ * Creates the simulation with the initial state taken from the current buffers of the interleaved grid
+ */
+gpu_simulation_t *create_gpu_simulation(const grid_t *grid, int generations, Uint64 seed);
+
+/**
+ * Sets a few random cells to random values, the same as add_disturbance() of the same seed and step
+ */
+void add_gpu_disturbance(gpu_simulation_t *simulation);
+
+/**
+ * Adds disturbance and advances the simulation by configured number of generations
+ */
+void step_gpu_simulation(gpu_simulation_t *simulation);
+
+/**
+ * Draws the current generation stretched over the viewport of the default frame buffer
+ */
+void present_gpu_simulation(gpu_simulation_t *simulation, int viewport_width, int viewport_height);
+
+/**
+ * Reads the current generation back into the current buffers of the interleaved grid of the same size
+ */
+void read_gpu_simulation(gpu_simulation_t *simulation, grid_t *grid);
+
+void destroy_gpu_simulation(gpu_simulation_t **pp_simulation);
+
+#endif //SDL_TEST_GPU_SIMULATION_H
@@ -0,0 +1,176 @@
+#include "grid.h"
+#include "pixels.h"
+#include "random.h"
+#include "../opengl/sdl_ext.h"
+#include <sys/mman.h>
+
+static const char *GRID_LAYOUT_NAMES[GRID_LAYOUT_LAST_TYPE] = {"interleaved", "planar"};
+
+grid_t *
+create_grid(int width, int height, grid_layout_t layout) {
+    grid_t *grid = calloc(1, sizeof(grid_t));
+    SDL_ALLOC_CHECK(grid)
+    grid->width = width;
+    grid->height = height;
+    grid->layout = layout;
+
+    // interleaved layout keeps one buffer for all channels, planar - one per channel
+    size_t buffers_number;
+    if (layout == GRID_LAYOUT_INTERLEAVED) {
+        grid->cell_stride = CHANNELS_NUMBER;
+        buffers_number = 2;
+    } else {
+        grid->cell_stride = 1;
+        buffers_number = 2 * CHANNELS_NUMBER;
+    }
+    grid->buffer_size = ((size_t) width * height * grid->cell_stride + GRID_ALIGNMENT - 1) &
+                        ~(size_t) (GRID_ALIGNMENT - 1);
+
+    size_t arena_size = grid->buffer_size * buffers_number;
+    size_t alignment = arena_size >= GRID_HUGE_PAGE_SIZE ? GRID_HUGE_PAGE_SIZE : GRID_ALIGNMENT;
+    void *arena = NULL;
+    if (posix_memalign(&arena, alignment, arena_size) != 0) {
+        SDL_Die("Error allocating %zu bytes for %dx%d grid", arena_size, width, height);
+    }
+#ifdef MADV_HUGEPAGE
+    if (alignment == GRID_HUGE_PAGE_SIZE) {
+        madvise(arena, arena_size, MADV_HUGEPAGE);
+    }
+#endif
+    // touching all pages once, so the first steps do not page fault
+    memset(arena, 0, arena_size);
+    grid->arena = arena;
+
+    for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+        if (layout == GRID_LAYOUT_INTERLEAVED) {
+            grid->current[channel] = grid->arena + channel;
+            grid->next[channel] = grid->arena + grid->buffer_size + channel;
+        } else {
+            grid->current[channel] = grid->arena + grid->buffer_size * channel;
+            grid->next[channel] = grid->arena + grid->buffer_size * (CHANNELS_NUMBER + channel);
+        }
+    }
+    return grid;
+}
+
+grid_t *
+create_grid_view(int width, int height, grid_layout_t layout, Uint8 *cells) {
+    grid_t *grid = calloc(1, sizeof(grid_t));
+    SDL_ALLOC_CHECK(grid)
+    grid->width = width;
+    grid->height = height;
+    grid->layout = layout;
+    grid->cell_stride = layout == GRID_LAYOUT_INTERLEAVED ? CHANNELS_NUMBER : 1;
+    grid->buffer_size = grid_cells_size(grid);
+    for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+        if (layout == GRID_LAYOUT_INTERLEAVED) {
+            grid->current[channel] = cells + channel;
+        } else {
+            grid->current[channel] = cells + grid->buffer_size * channel;
+        }
+    }
+    return grid;
+}
+
+box_filter_scratch_t *
+create_grid_filter_scratch(const grid_t *grid) {
+    return create_box_filter_scratch(grid->width, grid->cell_stride);
+}
+
+void
+step_grid_rows(grid_t *grid, box_filter_t box_filter, box_filter_scratch_t *scratch, int row_from, int row_to) {
+    if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+        box_filter(grid->current[0], grid->next[0], grid->width, grid->height, CHANNELS_NUMBER, row_from, row_to,
+                   scratch);
+    } else {
+        for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+            box_filter(grid->current[channel], grid->next[channel], grid->width, grid->height, 1, row_from, row_to,
+                       scratch);
+        }
+    }
+}
+
+void
+step_grid_rows_radius(grid_t *grid, int radius, box_filter_scratch_t *scratch, int row_from, int row_to) {
+    if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+        box_filter_running_sum(grid->current[0], grid->next[0], grid->width, grid->height, CHANNELS_NUMBER, radius,
+                               row_from, row_to, scratch);
+    } else {
+        for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+            box_filter_running_sum(grid->current[channel], grid->next[channel], grid->width, grid->height, 1, radius,
+                                   row_from, row_to, scratch);
+        }
+    }
+}
+
+void
+swap_grid_buffers(grid_t *grid) {
+    for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+        Uint8 *buffer = grid->current[channel];
+        grid->current[channel] = grid->next[channel];
+        grid->next[channel] = buffer;
+    }
+}
+
+void
+pack_grid_row(const grid_t *grid, int x, int y, int count, Uint32 *target) {
+    if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+        pack_interleaved_rgb(grid_cell(grid, CHANNEL_RED, x, y), target, count);
+    } else {
+        pack_planar_rgb(grid_cell(grid, CHANNEL_RED, x, y), grid_cell(grid, CHANNEL_GREEN, x, y),
+                        grid_cell(grid, CHANNEL_BLUE, x, y), target, count);
+    }
+}
+
+void
+sample_grid_row(const grid_t *grid, int x, int y, int step, int count, Uint32 *target) {
+    if (step == 1) {
+        pack_grid_row(grid, x, y, count, target);
+        return;
+    }
+    const Uint8 *red = grid_cell(grid, CHANNEL_RED, x, y);
+    const Uint8 *green = grid_cell(grid, CHANNEL_GREEN, x, y);
+    const Uint8 *blue = grid_cell(grid, CHANNEL_BLUE, x, y);
+    size_t cell_step = (size_t) step * grid->cell_stride;
+    for (int i = 0; i < count; i++) {
+        size_t offset = i * cell_step;
+        target[i] = PACK_ARGB(red[offset], green[offset], blue[offset]);
+    }
+}
+
+void
+copy_grid_rows(const grid_t *source, int source_row, grid_t *target, int target_row, int rows) {
+    size_t size = (size_t) rows * source->width * source->cell_stride;
+    int buffers = source->layout == GRID_LAYOUT_INTERLEAVED ? 1 : CHANNELS_NUMBER;
+    for (int channel = 0; channel < buffers; channel++) {
+        memcpy(grid_cell(target, channel, 0, target_row), grid_cell(source, channel, 0, source_row), size);
+    }
+}
+
+void
+randomize_grid(grid_t *grid, Uint64 seed, size_t from, size_t to) {
+    size_t size = grid_cells_size(grid);
+    if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+        fill_random(seed, RANDOM_STREAM_GRID, from, grid->current[0] + from, to - from);
+        return;
+    }
+    for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+        fill_random(seed, RANDOM_STREAM_GRID, channel * size + from, grid->current[channel] + from, to - from);
+    }
+}
+
+void
+destroy_grid(grid_t **pp_grid) {
+    grid_t *grid = *pp_grid;
+    if (grid == NULL) {
+        return;
+    }
+    free(grid->arena);
+    free(grid);
+    *pp_grid = NULL;
+}
+
+const char *
+grid_layout_name(grid_layout_t layout) {
+    return layout < GRID_LAYOUT_LAST_TYPE ? GRID_LAYOUT_NAMES[layout] : "unknown";
+}
@@ -0,0 +1,116 @@
+#ifndef SDL_TEST_GRID_H
+#define SDL_TEST_GRID_H
+
+#include <SDL2/SDL.h>
+#include "box_filter.h"
+
+#define GRID_ALIGNMENT 64
+#define GRID_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+typedef enum {
+    CHANNEL_RED = 0,
+    CHANNEL_GREEN,
+    CHANNEL_BLUE,
+    CHANNELS_NUMBER
+} channel_t;
+
+typedef enum {
+    /**
+     * row-major RGB cells, all channels are filtered in a single sweep
+     */
+    GRID_LAYOUT_INTERLEAVED = 0,
+    /**
+     * row-major plane per channel, filtered one plane after another
+     */
+    GRID_LAYOUT_PLANAR,
+    GRID_LAYOUT_LAST_TYPE
+} grid_layout_t;
+
+/**
+ * Simulation grid with double buffered channels. All buffers live in a single aligned arena, a step reads current
+ * buffers, writes next ones and swaps the pointers, so steady state stepping does no heap traffic.
+ * current[channel] and next[channel] point to the first byte of the channel, cells of the channel are cell_stride
+ * bytes apart.
+ */
+typedef struct grid {
+    int width;
+    int height;
+    grid_layout_t layout;
+    int cell_stride;
+    /**
+     * size of a single buffer in bytes, rounded up to GRID_ALIGNMENT
+     */
+    size_t buffer_size;
+    Uint8 *arena;
+    Uint8 *current[CHANNELS_NUMBER];
+    Uint8 *next[CHANNELS_NUMBER];
+} grid_t;
+
+grid_t *create_grid(int width, int height, grid_layout_t layout);
+
+/**
+ * Wraps cells laid out as the current buffer of a grid, planes of planar grids one after another, without copying.
+ * The view does not own the cells and has no next buffers, so it can be read and filled but not stepped.
+ */
+grid_t *create_grid_view(int width, int height, grid_layout_t layout, Uint8 *cells);
+
+/**
+ * Creates filter scratch for rows of a single buffer of the grid
+ */
+box_filter_scratch_t *create_grid_filter_scratch(const grid_t *grid);
+
+/**
+ * Filters rows [row_from, row_to) of all channels from current buffers into the next ones, with the scratch of the
+ * calling worker created for the grid by create_grid_filter_scratch()
+ */
+void step_grid_rows(grid_t *grid, box_filter_t box_filter, box_filter_scratch_t *scratch, int row_from, int row_to);
+
+/**
+ * Same as step_grid_rows() with the running sum filter of the given radius
+ */
+void step_grid_rows_radius(grid_t *grid, int radius, box_filter_scratch_t *scratch, int row_from, int row_to);
+
+/**
+ * Makes next buffers current after a step
+ */
+void swap_grid_buffers(grid_t *grid);
+
+/**
+ * Packs count cells of the row y starting from x into ARGB8888 pixels
+ */
+void pack_grid_row(const grid_t *grid, int x, int y, int count, Uint32 *target);
+
+/**
+ * Packs count cells of the row y taken every step cells starting from x into ARGB8888 pixels
+ */
+void sample_grid_row(const grid_t *grid, int x, int y, int step, int count, Uint32 *target);
+
+/**
+ * Copies rows of the current buffers between grids of the same width and layout
+ */
+void copy_grid_rows(const grid_t *source, int source_row, grid_t *target, int target_row, int rows);
+
+/**
+ * Fills bytes [from, to) of the current buffers with the grid stream of the seed. Buffer bytes take consecutive
+ * stream bytes, planes of planar grids one after another, so any split of the range gives the same grid.
+ */
+void randomize_grid(grid_t *grid, Uint64 seed, size_t from, size_t to);
+
+void destroy_grid(grid_t **pp_grid);
+
+const char *grid_layout_name(grid_layout_t layout);
+
+static inline Uint8 *
+grid_cell(const grid_t *grid, channel_t channel, int x, int y) {
+    return grid->current[channel] + ((size_t) y * grid->width + x) * grid->cell_stride;
+}
+
+/**
+ * Bytes of cells in a single current buffer
+ */
+static inline size_t
+grid_cells_size(const grid_t *grid) {
+    return (size_t) grid->width * grid->height * grid->cell_stride;
+}
+
+#endif //SDL_TEST_GRID_H
@@ -0,0 +1,69 @@
+#include "pixels.h"
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+void
+pack_planar_rgb(const Uint8 *red, const Uint8 *green, const Uint8 *blue, Uint32 *target, unsigned int count) {
+    unsigned int i = 0;
+#ifdef __SSE2__
+    // ARGB8888 is stored as B, G, R, A bytes in memory, so we interleave b/g and r/alpha pairs and then the pairs
+    const __m128i alpha = _mm_set1_epi8((char) 0xff);
+    for (; i + 16 <= count; i += 16) {
+        __m128i r = _mm_loadu_si128((const __m128i *) (red + i));
+        __m128i g = _mm_loadu_si128((const __m128i *) (green + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (blue + i));
+
+        __m128i bg_low = _mm_unpacklo_epi8(b, g);
+        __m128i bg_high = _mm_unpackhi_epi8(b, g);
+        __m128i ra_low = _mm_unpacklo_epi8(r, alpha);
+        __m128i ra_high = _mm_unpackhi_epi8(r, alpha);
+
+        _mm_storeu_si128((__m128i *) (target + i), _mm_unpacklo_epi16(bg_low, ra_low));
+        _mm_storeu_si128((__m128i *) (target + i + 4), _mm_unpackhi_epi16(bg_low, ra_low));
+        _mm_storeu_si128((__m128i *) (target + i + 8), _mm_unpacklo_epi16(bg_high, ra_high));
+        _mm_storeu_si128((__m128i *) (target + i + 12), _mm_unpackhi_epi16(bg_high, ra_high));
+    }
+#endif
+    for (; i < count; i++) {
+        target[i] = PACK_ARGB(red[i], green[i], blue[i]);
+    }
+}
+
+#ifdef __SSE2__
+
+/**
+ * Spreading four RGB triplets of the 16 loaded bytes into B, G, R, 0 quads, SSE4.1 implies SSSE3 shuffles
+ */
+__attribute__((target("sse4.1"))) static unsigned int
+pack_interleaved_rgb_ssse3(const Uint8 *rgb, Uint32 *target, unsigned int count) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+    unsigned int i = 0;
+    // the last load reads 4 bytes past the pixels it packs, so it has to stay within count triplets
+    for (; i * 3 + 16 <= count * 3; i += 4) {
+        __m128i triplets = _mm_loadu_si128((const __m128i *) (rgb + i * 3));
+        _mm_storeu_si128((__m128i *) (target + i), _mm_or_si128(_mm_shuffle_epi8(triplets, shuffle), alpha));
+    }
+    return i;
+}
+
+#endif
+
+void
+pack_interleaved_rgb(const Uint8 *rgb, Uint32 *target, unsigned int count) {
+    unsigned int i = 0;
+#ifdef __SSE2__
+    static int shuffle_supported = -1;
+    if (shuffle_supported < 0) {
+        shuffle_supported = SDL_HasSSE41();
+    }
+    if (shuffle_supported) {
+        i = pack_interleaved_rgb_ssse3(rgb, target, count);
+    }
+#endif
+    for (; i < count; i++) {
+        target[i] = PACK_ARGB(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef SDL_TEST_PIXELS_H
+#define SDL_TEST_PIXELS_H
+
+#include <SDL2/SDL.h>
+
+#define PACK_ARGB(r, g, b) (0xff000000u | (Uint32) (r) << 16 | (Uint32) (g) << 8 | (Uint32) (b))
+
+/**
+ * Packs count cells of three planar channels into ARGB8888 pixels (alpha is always opaque)
+ */
+void pack_planar_rgb(const Uint8 *red, const Uint8 *green, const Uint8 *blue, Uint32 *target, unsigned int count);
+
+/**
+ * Packs count RGB byte triplets into ARGB8888 pixels (alpha is always opaque)
+ */
+void pack_interleaved_rgb(const Uint8 *rgb, Uint32 *target, unsigned int count);
+
+#endif //SDL_TEST_PIXELS_H
@@ -0,0 +1,155 @@
+#include "random.h"
+#include "../opengl/sdl_ext.h"
+
+static void
+philox(const Uint32 counter[4], const Uint32 key[2], Uint32 words[4]) {
+    Uint32 c0 = counter[0];
+    Uint32 c1 = counter[1];
+    Uint32 c2 = counter[2];
+    Uint32 c3 = counter[3];
+    Uint32 k0 = key[0];
+    Uint32 k1 = key[1];
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        Uint64 product0 = (Uint64) PHILOX_M0 * c0;
+        Uint64 product1 = (Uint64) PHILOX_M1 * c2;
+        c0 = (Uint32) (product1 >> 32) ^ c1 ^ k0;
+        c1 = (Uint32) product1;
+        c2 = (Uint32) (product0 >> 32) ^ c3 ^ k1;
+        c3 = (Uint32) product0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    words[0] = c0;
+    words[1] = c1;
+    words[2] = c2;
+    words[3] = c3;
+}
+
+void
+random_block(Uint64 seed, random_stream_t stream, Uint64 block, Uint32 words[4]) {
+    const Uint32 counter[4] = {(Uint32) block, (Uint32) (block >> 32), stream, 0};
+    const Uint32 key[2] = {(Uint32) seed, (Uint32) (seed >> 32)};
+    philox(counter, key, words);
+}
+
+void
+random_blocks_scalar(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        Uint32 words[4];
+        random_block(seed, stream, block + i, words);
+        for (int j = 0; j < 4; j++) {
+            words[j] = SDL_SwapLE32(words[j]);
+        }
+        SDL_memcpy(target + i * RANDOM_BLOCK_SIZE, words, RANDOM_BLOCK_SIZE);
+    }
+}
+
+static random_blocks_t
+get_random_blocks() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (SDL_HasAVX2()) {
+        return random_blocks_avx2;
+    } else if (SDL_HasSSE2()) {
+        return random_blocks_sse2;
+    }
+#endif
+    return random_blocks_scalar;
+}
+
+static void
+fill_random_with(random_blocks_t random_blocks, Uint64 seed, random_stream_t stream, Uint64 offset, Uint8 *target,
+                 size_t size) {
+    Uint8 partial[RANDOM_BLOCK_SIZE];
+    Uint64 block = offset / RANDOM_BLOCK_SIZE;
+    size_t skip = offset % RANDOM_BLOCK_SIZE;
+    if (skip != 0 && size > 0) {
+        size_t count = SDL_min(size, RANDOM_BLOCK_SIZE - skip);
+        random_blocks_scalar(seed, stream, block++, partial, 1);
+        SDL_memcpy(target, partial + skip, count);
+        target += count;
+        size -= count;
+    }
+    size_t blocks = size / RANDOM_BLOCK_SIZE;
+    random_blocks(seed, stream, block, target, blocks);
+    size_t tail = size % RANDOM_BLOCK_SIZE;
+    if (tail != 0) {
+        random_blocks_scalar(seed, stream, block + blocks, partial, 1);
+        SDL_memcpy(target + blocks * RANDOM_BLOCK_SIZE, partial, tail);
+    }
+}
+
+void
+fill_random(Uint64 seed, random_stream_t stream, Uint64 offset, Uint8 *target, size_t size) {
+    fill_random_with(get_random_blocks(), seed, stream, offset, target, size);
+}
+
+/**
+ * Known answers of Philox4x32-10 from the Random123 distribution
+ */
+static bool
+verify_known_answers() {
+    static const struct {
+        Uint32 counter[4];
+        Uint32 key[2];
+        Uint32 words[4];
+    } ANSWERS[] = {
+            {{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+            {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+                    {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+            {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+                    {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}
+    };
+    for (int i = 0; i < SDL_arraysize(ANSWERS); i++) {
+        Uint32 words[4];
+        philox(ANSWERS[i].counter, ANSWERS[i].key, words);
+        if (SDL_memcmp(words, ANSWERS[i].words, sizeof(words)) != 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Philox differs from the known answer %d", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+verify_random_blocks(const char *name, random_blocks_t random_blocks) {
+    static const size_t SIZES[] = {0, 1, 15, 16, 17, 100, 255, 4096, 10007};
+    static const Uint64 OFFSETS[] = {0, 3, 16, 0xffffffffull * RANDOM_BLOCK_SIZE - 40};
+    const Uint64 seed = 0x0123456789abcdefull;
+    bool passed = true;
+    for (int i = 0; i < SDL_arraysize(SIZES) && passed; i++) {
+        for (int j = 0; j < SDL_arraysize(OFFSETS) && passed; j++) {
+            Uint8 *expected = malloc(SIZES[i] + 1);
+            Uint8 *actual = malloc(SIZES[i] + 1);
+            SDL_ALLOC_CHECK(expected)
+            SDL_ALLOC_CHECK(actual)
+            fill_random_with(random_blocks_scalar, seed, RANDOM_STREAM_GRID, OFFSETS[j], expected, SIZES[i]);
+            fill_random_with(random_blocks, seed, RANDOM_STREAM_GRID, OFFSETS[j], actual, SIZES[i]);
+            if (SDL_memcmp(expected, actual, SIZES[i]) != 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                             "Random fill %s differs from scalar at offset %llu, size %zu", name,
+                             (unsigned long long) OFFSETS[j], SIZES[i]);
+                passed = false;
+            }
+            free(actual);
+            free(expected);
+        }
+    }
+    if (passed) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Random fill %s: matches scalar", name);
+    }
+    return passed;
+}
+
+bool
+verify_random() {
+    bool passed = verify_known_answers();
+#if defined(__x86_64__) || defined(__i386__)
+    if (SDL_HasSSE2()) {
+        passed &= verify_random_blocks("sse2", random_blocks_sse2);
+    }
+    if (SDL_HasAVX2()) {
+        passed &= verify_random_blocks("avx2", random_blocks_avx2);
+    }
+#endif
+    return passed;
+}
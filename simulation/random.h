@@ -0,0 +1,63 @@
+#ifndef SDL_TEST_RANDOM_H
+#define SDL_TEST_RANDOM_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+#define RANDOM_BLOCK_SIZE 16
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+/**
+ * Independent random streams of the same seed
+ */
+typedef enum {
+    RANDOM_STREAM_GRID = 0,
+    RANDOM_STREAM_DISTURBANCE
+} random_stream_t;
+
+/**
+ * Philox4x32-10 counter-based generator: block n of a stream is a pure function of the seed, the stream and n, so
+ * any part of a stream can be generated by any thread in any order with the same result on every platform.
+ * A block is four 32-bit words, byte streams take words in little endian order.
+ */
+void random_block(Uint64 seed, random_stream_t stream, Uint64 block, Uint32 words[4]);
+
+/**
+ * Fills size bytes of the target with the stream starting at byte offset of the stream
+ */
+void fill_random(Uint64 seed, random_stream_t stream, Uint64 offset, Uint8 *target, size_t size);
+
+/**
+ * Maps a random word to [0, bound) by multiplication, without the division of the modulo
+ */
+static inline Uint32
+random_below(Uint32 word, Uint32 bound) {
+    return (Uint32) (((Uint64) word * bound) >> 32);
+}
+
+/**
+ * Checks the generator against known answers and vectorized fills against the scalar one
+ */
+bool verify_random();
+
+/**
+ * Fills count whole blocks starting at block, implementations generate the same bytes
+ */
+typedef void (*random_blocks_t)(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count);
+
+void random_blocks_scalar(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count);
+
+#if defined(__x86_64__) || defined(__i386__)
+
+void random_blocks_sse2(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count);
+
+void random_blocks_avx2(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count);
+
+#endif
+
+#endif //SDL_TEST_RANDOM_H
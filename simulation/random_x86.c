@@ -0,0 +1,122 @@
+#include "random.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/**
+ * Blocks are generated several at a time with counter words in structure of arrays form: lane i of c0..c3 holds
+ * the counter of block + i. 32x32 bit products come from the 64-bit multiplication of even lanes, applied to
+ * the words and to the words shifted down to even positions. Results are transposed back to consecutive blocks.
+ * Vector loops need the low counter word not to wrap within the vector, the rare vectors where it does are left to
+ * the scalar generator.
+ */
+
+__attribute__((target("sse2"))) static inline void
+multiply_sse2(__m128i a, __m128i b, __m128i *high, __m128i *low) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+    // lo0 lo2 hi0 hi2 and lo1 lo3 hi1 hi3
+    even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));
+    odd = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+    *low = _mm_unpacklo_epi32(even, odd);
+    *high = _mm_unpackhi_epi32(even, odd);
+}
+
+__attribute__((target("sse2"))) void
+random_blocks_sse2(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count) {
+    const __m128i m0 = _mm_set1_epi32((int) PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int) PHILOX_M1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Uint64 first = block + i;
+        if ((Uint32) first > UINT32_MAX - 3) {
+            random_blocks_scalar(seed, stream, first, target + i * RANDOM_BLOCK_SIZE, 4);
+            continue;
+        }
+        __m128i c0 = _mm_add_epi32(_mm_set1_epi32((int) (Uint32) first), _mm_setr_epi32(0, 1, 2, 3));
+        __m128i c1 = _mm_set1_epi32((int) (Uint32) (first >> 32));
+        __m128i c2 = _mm_set1_epi32((int) stream);
+        __m128i c3 = _mm_setzero_si128();
+        Uint32 k0 = (Uint32) seed;
+        Uint32 k1 = (Uint32) (seed >> 32);
+        for (int round = 0; round < PHILOX_ROUNDS; round++) {
+            __m128i high0, low0, high1, low1;
+            multiply_sse2(c0, m0, &high0, &low0);
+            multiply_sse2(c2, m1, &high1, &low1);
+            c0 = _mm_xor_si128(_mm_xor_si128(high1, c1), _mm_set1_epi32((int) k0));
+            c1 = low1;
+            c2 = _mm_xor_si128(_mm_xor_si128(high0, c3), _mm_set1_epi32((int) k1));
+            c3 = low0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+        __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+        __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+        __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+        __m128i *blocks = (__m128i *) (target + i * RANDOM_BLOCK_SIZE);
+        _mm_storeu_si128(blocks, _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128(blocks + 1, _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128(blocks + 2, _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128(blocks + 3, _mm_unpackhi_epi64(t2, t3));
+    }
+    random_blocks_scalar(seed, stream, block + i, target + i * RANDOM_BLOCK_SIZE, count - i);
+}
+
+__attribute__((target("avx2"))) static inline void
+multiply_avx2(__m256i a, __m256i b, __m256i *high, __m256i *low) {
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    *low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+    *high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+__attribute__((target("avx2"))) void
+random_blocks_avx2(Uint64 seed, random_stream_t stream, Uint64 block, Uint8 *target, size_t count) {
+    const __m256i m0 = _mm256_set1_epi32((int) PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi32((int) PHILOX_M1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        Uint64 first = block + i;
+        if ((Uint32) first > UINT32_MAX - 7) {
+            random_blocks_scalar(seed, stream, first, target + i * RANDOM_BLOCK_SIZE, 8);
+            continue;
+        }
+        __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32((int) (Uint32) first),
+                                      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i c1 = _mm256_set1_epi32((int) (Uint32) (first >> 32));
+        __m256i c2 = _mm256_set1_epi32((int) stream);
+        __m256i c3 = _mm256_setzero_si256();
+        Uint32 k0 = (Uint32) seed;
+        Uint32 k1 = (Uint32) (seed >> 32);
+        for (int round = 0; round < PHILOX_ROUNDS; round++) {
+            __m256i high0, low0, high1, low1;
+            multiply_avx2(c0, m0, &high0, &low0);
+            multiply_avx2(c2, m1, &high1, &low1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(high1, c1), _mm256_set1_epi32((int) k0));
+            c1 = low1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(high0, c3), _mm256_set1_epi32((int) k1));
+            c3 = low0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        // unpacking works within 128-bit lanes: blocks 0-3 in low lanes and 4-7 in high ones
+        __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+        __m256i t1 = _mm256_unpacklo_epi32(c2, c3);
+        __m256i t2 = _mm256_unpackhi_epi32(c0, c1);
+        __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+        __m256i b04 = _mm256_unpacklo_epi64(t0, t1);
+        __m256i b15 = _mm256_unpackhi_epi64(t0, t1);
+        __m256i b26 = _mm256_unpacklo_epi64(t2, t3);
+        __m256i b37 = _mm256_unpackhi_epi64(t2, t3);
+        __m256i *blocks = (__m256i *) (target + i * RANDOM_BLOCK_SIZE);
+        _mm256_storeu_si256(blocks, _mm256_permute2x128_si256(b04, b15, 0x20));
+        _mm256_storeu_si256(blocks + 1, _mm256_permute2x128_si256(b26, b37, 0x20));
+        _mm256_storeu_si256(blocks + 2, _mm256_permute2x128_si256(b04, b15, 0x31));
+        _mm256_storeu_si256(blocks + 3, _mm256_permute2x128_si256(b26, b37, 0x31));
+    }
+    random_blocks_scalar(seed, stream, block + i, target + i * RANDOM_BLOCK_SIZE, count - i);
+}
+
+#endif
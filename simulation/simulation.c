@@ -0,0 +1,191 @@
+#include "simulation.h"
+#include "random.h"
+#include "../opengl/sdl_ext.h"
+
+static const char *STEP_MODE_NAMES[STEP_LAST_MODE] = {"full", "tiled", "active"};
+
+simulation_t *
+create_simulation(const simulation_config_t *config, worker_pool_t *worker_pool) {
+    if (config->generations <= 0) {
+        SDL_Die("Number of generations per step should be positive");
+    }
+    if (config->radius < 1 || config->radius > BOX_FILTER_MAX_RADIUS) {
+        SDL_Die("Filter radius should be from 1 to %d", BOX_FILTER_MAX_RADIUS);
+    }
+    if (config->radius > 1 && config->step_mode != STEP_FULL) {
+        SDL_Die("Filter radius %d is supported by %s steps only", config->radius, step_mode_name(STEP_FULL));
+    }
+    if (config->processes > 1 && config->step_mode != STEP_FULL) {
+        SDL_Die("Simulation of %d processes supports %s steps only", config->processes, step_mode_name(STEP_FULL));
+    }
+    simulation_t *simulation = calloc(1, sizeof(simulation_t));
+    SDL_ALLOC_CHECK(simulation)
+    simulation->config = *config;
+    simulation->box_filter = get_box_filter(config->box_filter_type);
+    simulation->worker_pool = worker_pool;
+    if (config->processes > 1) {
+        domain_config_t domain_config = {
+                .width = config->width,
+                .height = config->height,
+                .layout = config->layout,
+                .box_filter_type = config->box_filter_type,
+                .radius = config->radius,
+                .generations = config->generations,
+                .seed = config->seed,
+                .ranks = config->processes
+        };
+        simulation->domain = create_domain(&domain_config);
+        simulation->grid = create_grid_view(config->width, config->height, config->layout,
+                                             simulation->domain->frame->current[0]);
+        return simulation;
+    }
+    simulation->grid = create_grid(config->width, config->height, config->layout);
+    simulation->workers_number = worker_pool->workers_number;
+    simulation->box_filter_scratch = calloc(simulation->workers_number, sizeof(box_filter_scratch_t *));
+    SDL_ALLOC_CHECK(simulation->box_filter_scratch)
+    for (unsigned int i = 0; i < simulation->workers_number; i++) {
+        simulation->box_filter_scratch[i] = create_grid_filter_scratch(simulation->grid);
+    }
+    if (config->step_mode == STEP_TEMPORAL_TILES) {
+        simulation->temporal_tiling = create_temporal_tiling(simulation->grid, config->generations,
+                                                             worker_pool->workers_number);
+    } else if (config->step_mode == STEP_ACTIVE_TILES) {
+        simulation->active_region = create_active_region(simulation->grid, worker_pool->workers_number);
+    }
+    return simulation;
+}
+
+static void
+randomize_band(void *data, unsigned int band_index, unsigned int bands_number) {
+    simulation_t *simulation = data;
+    size_t size = grid_cells_size(simulation->grid);
+    randomize_grid(simulation->grid, simulation->config.seed, size * band_index / bands_number,
+                   size * (band_index + 1) / bands_number);
+}
+
+void
+randomize_simulation(simulation_t *simulation) {
+    if (simulation->domain != NULL) {
+        return;
+    }
+    run_worker_pool(simulation->worker_pool, randomize_band, simulation);
+    if (simulation->active_region != NULL) {
+        mark_active_region(simulation->active_region);
+    }
+}
+
+void
+get_disturbance(Uint64 seed, Uint64 step, int index, int width, int height, disturbance_t *disturbance) {
+    Uint32 words[4];
+    random_block(seed, RANDOM_STREAM_DISTURBANCE, step * DISTURBANCES_PER_STEP + index, words);
+    disturbance->x = (int) random_below(words[0], width);
+    disturbance->y = (int) random_below(words[1], height);
+    for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+        disturbance->cell[channel] = (Uint8) (words[2] >> (8 * channel));
+    }
+}
+
+void
+add_disturbance(simulation_t *simulation) {
+    grid_t *grid = simulation->grid;
+    for (int i = 0; i < DISTURBANCES_PER_STEP; i++) {
+        disturbance_t disturbance;
+        get_disturbance(simulation->config.seed, simulation->step, i, grid->width, grid->height, &disturbance);
+        for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+            *grid_cell(grid, channel, disturbance.x, disturbance.y) = disturbance.cell[channel];
+        }
+        if (simulation->active_region != NULL) {
+            mark_active_cell(simulation->active_region, disturbance.x, disturbance.y);
+        }
+    }
+    simulation->step++;
+}
+
+/**
+ * Filters a horizontal band of all channels. Rows around the band are read from the current buffers, so bands do
+ * not depend on each other.
+ */
+static void
+step_band(void *data, unsigned int band_index, unsigned int bands_number) {
+    simulation_t *simulation = data;
+    grid_t *grid = simulation->grid;
+    box_filter_scratch_t *scratch = simulation->box_filter_scratch[band_index];
+    if (simulation->active_region != NULL) {
+        int tiles_y = simulation->active_region->tiles_y;
+        step_grid_tiles_active(simulation->active_region, band_index, grid, simulation->box_filter, scratch,
+                               (int) ((Uint64) tiles_y * band_index / bands_number),
+                               (int) ((Uint64) tiles_y * (band_index + 1) / bands_number));
+        return;
+    }
+    int row_from = (int) ((Uint64) grid->height * band_index / bands_number);
+    int row_to = (int) ((Uint64) grid->height * (band_index + 1) / bands_number);
+    if (simulation->config.radius > 1) {
+        step_grid_rows_radius(grid, simulation->config.radius, scratch, row_from, row_to);
+    } else if (simulation->temporal_tiling != NULL) {
+        step_grid_rows_tiled(simulation->temporal_tiling, band_index, grid, simulation->box_filter, scratch, row_from,
+                             row_to);
+    } else {
+        step_grid_rows(grid, simulation->box_filter, scratch, row_from, row_to);
+    }
+}
+
+void
+step_simulation(simulation_t *simulation) {
+    if (simulation->domain != NULL) {
+        step_domain(simulation->domain);
+        simulation->step++;
+        return;
+    }
+    add_disturbance(simulation);
+    if (simulation->temporal_tiling != NULL) {
+        run_worker_pool(simulation->worker_pool, step_band, simulation);
+        swap_grid_buffers(simulation->grid);
+        return;
+    }
+    for (int generation = 0; generation < simulation->config.generations; generation++) {
+        run_worker_pool(simulation->worker_pool, step_band, simulation);
+        swap_grid_buffers(simulation->grid);
+        if (simulation->active_region != NULL) {
+            swap_active_region(simulation->active_region);
+        }
+    }
+}
+
+bool
+take_simulation_changed_rows(simulation_t *simulation, int row, int *row_from, int *row_to) {
+    int height = simulation->grid->height;
+    if (simulation->active_region != NULL) {
+        return take_changed_rows(simulation->active_region, height, row, row_from, row_to);
+    }
+    if (row >= height) {
+        return false;
+    }
+    *row_from = row;
+    *row_to = height;
+    return true;
+}
+
+void
+destroy_simulation(simulation_t **pp_simulation) {
+    simulation_t *simulation = *pp_simulation;
+    if (simulation == NULL) {
+        return;
+    }
+    destroy_temporal_tiling(&simulation->temporal_tiling);
+    destroy_active_region(&simulation->active_region);
+    if (simulation->box_filter_scratch != NULL) {
+        for (unsigned int i = 0; i < simulation->workers_number; i++) {
+            destroy_box_filter_scratch(&simulation->box_filter_scratch[i]);
+        }
+        free(simulation->box_filter_scratch);
+    }
+    destroy_grid(&simulation->grid);
+    destroy_domain(&simulation->domain);
+    free(simulation);
+    *pp_simulation = NULL;
+}
+
+const char *
+step_mode_name(step_mode_t step_mode) {
+    return step_mode < STEP_LAST_MODE ? STEP_MODE_NAMES[step_mode] : "unknown";
+}
@@ -0,0 +1,123 @@
+#ifndef SDL_TEST_SIMULATION_H
+#define SDL_TEST_SIMULATION_H
+
+#include "grid.h"
+#include "box_filter.h"
+#include "worker_pool.h"
+#include "temporal_tiling.h"
+#include "active_region.h"
+#include "domain.h"
+
+#define DISTURBANCES_PER_STEP 10
+
+typedef enum {
+    /**
+     * every generation is a full sweep over the grid
+     */
+    STEP_FULL = 0,
+    /**
+     * all generations of a step are advanced tile by tile, see temporal_tiling_t
+     */
+    STEP_TEMPORAL_TILES,
+    /**
+     * generation by generation, only tiles next to changed ones, see active_region_t
+     */
+    STEP_ACTIVE_TILES,
+    STEP_LAST_MODE
+} step_mode_t;
+
+typedef struct simulation_config {
+    int width;
+    int height;
+    grid_layout_t layout;
+    box_filter_type_t box_filter_type;
+    step_mode_t step_mode;
+    /**
+     * generations advanced by a single step
+     */
+    int generations;
+    /**
+     * neighbourhood radius of the filter, 1 is the 3x3 box filter of box_filter_type, larger radii use the running sum
+     * filter and full steps only
+     */
+    int radius;
+    /**
+     * seed of the initial grid and of disturbances, equal seeds give equal runs
+     */
+    Uint64 seed;
+    /**
+     * processes sharing the grid, above 1 the grid is a domain of bands stepped by separate processes
+     */
+    int processes;
+} simulation_config_t;
+
+/**
+ * Cell set by a disturbance
+ */
+typedef struct disturbance {
+    int x;
+    int y;
+    Uint8 cell[CHANNELS_NUMBER];
+} disturbance_t;
+
+/**
+ * Diffusion simulation: grid stepped with the box filter in horizontal bands, one band per worker
+ */
+typedef struct simulation {
+    simulation_config_t config;
+    grid_t *grid;
+    box_filter_t box_filter;
+    worker_pool_t *worker_pool;
+    /**
+     * filter scratch of every worker of the pool
+     */
+    unsigned int workers_number;
+    box_filter_scratch_t **box_filter_scratch;
+    temporal_tiling_t *temporal_tiling;
+    active_region_t *active_region;
+    /**
+     * processes stepping the grid, which is a view of the domain frame then
+     */
+    domain_t *domain;
+    /**
+     * steps taken, counter of disturbances
+     */
+    Uint64 step;
+} simulation_t;
+
+/**
+ * Creates a simulation with zeroed grid. Worker pool is attached, not owned, so it can be shared between simulations.
+ */
+simulation_t *create_simulation(const simulation_config_t *config, worker_pool_t *worker_pool);
+
+/**
+ * Fills all cells with random values of the seed, split between workers. Domain ranks are filled when created.
+ */
+void randomize_simulation(simulation_t *simulation);
+
+/**
+ * Gets disturbance index of the step, disturbances depend on the seed, the step and the grid size only
+ */
+void get_disturbance(Uint64 seed, Uint64 step, int index, int width, int height, disturbance_t *disturbance);
+
+/**
+ * Sets a few random cells of the current step to random values
+ */
+void add_disturbance(simulation_t *simulation);
+
+/**
+ * Adds disturbance and advances the simulation by configured number of generations
+ */
+void step_simulation(simulation_t *simulation);
+
+/**
+ * Finds the first span of rows at or after the row changed since it was taken, so presentation may skip rows which
+ * are already up to date. Without active region tracking all rows are reported as changed.
+ */
+bool take_simulation_changed_rows(simulation_t *simulation, int row, int *row_from, int *row_to);
+
+void destroy_simulation(simulation_t **pp_simulation);
+
+const char *step_mode_name(step_mode_t step_mode);
+
+#endif //SDL_TEST_SIMULATION_H
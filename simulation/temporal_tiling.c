@@ -0,0 +1,105 @@
+#include "temporal_tiling.h"
+#include "../opengl/sdl_ext.h"
+#include <unistd.h>
+
+static size_t
+get_cache_size() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long cache_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (cache_size > 0) {
+        return (size_t) cache_size;
+    }
+#endif
+    return TEMPORAL_TILING_DEFAULT_CACHE_SIZE;
+}
+
+temporal_tiling_t *
+create_temporal_tiling(const grid_t *grid, int generations, unsigned int workers_number) {
+    temporal_tiling_t *tiling = calloc(1, sizeof(temporal_tiling_t));
+    SDL_ALLOC_CHECK(tiling)
+    tiling->generations = generations;
+    tiling->workers_number = workers_number;
+
+    // planar channels are tiled one after another, so the scratch is sized for a single buffer of the grid
+    size_t row_size = (size_t) grid->width * grid->cell_stride;
+    // the source window and two scratch buffers of the same height should fit the cache
+    long tile_rows = (long) (get_cache_size() / (3 * row_size)) - 2 * generations;
+    tiling->tile_rows = (int) SDL_max(tile_rows, TEMPORAL_TILING_MIN_TILE_ROWS);
+    tiling->scratch_size = (size_t) (tiling->tile_rows + 2 * generations) * row_size;
+
+    tiling->scratch = calloc(workers_number, sizeof(Uint8 *));
+    SDL_ALLOC_CHECK(tiling->scratch)
+    for (unsigned int i = 0; i < workers_number; i++) {
+        tiling->scratch[i] = SDL_SIMDAlloc(2 * tiling->scratch_size);
+        SDL_ALLOC_CHECK(tiling->scratch[i])
+    }
+    return tiling;
+}
+
+/**
+ * Advances rows [tile_from, tile_to) of a single buffer by generations. The window of rows read from the source is
+ * processed as a grid of its own: its borders are grid borders only where the window is clamped by the grid, other
+ * rows next to the window borders are never computed, so zero padding of the filter there does not matter.
+ */
+static void
+advance_tile(const Uint8 *source, Uint8 *target, int width, int height, int channels, box_filter_t box_filter,
+             box_filter_scratch_t *filter_scratch, int generations, int tile_from, int tile_to, Uint8 *scratch,
+             size_t scratch_size) {
+    size_t row_size = (size_t) width * channels;
+    int window_from = SDL_max(0, tile_from - generations);
+    int window_to = SDL_min(height, tile_to + generations);
+    int window_height = window_to - window_from;
+    bool top_border = window_from == 0;
+    bool bottom_border = window_to == height;
+
+    const Uint8 *generation_source = source + window_from * row_size;
+    for (int generation = 1; generation <= generations; generation++) {
+        Uint8 *generation_target;
+        int rows_from;
+        int rows_to;
+        if (generation == generations) {
+            generation_target = target + window_from * row_size;
+            rows_from = tile_from - window_from;
+            rows_to = tile_to - window_from;
+        } else {
+            generation_target = scratch + (generation % 2) * scratch_size;
+            rows_from = top_border ? 0 : generation;
+            rows_to = bottom_border ? window_height : window_height - generation;
+        }
+        box_filter(generation_source, generation_target, width, window_height, channels, rows_from, rows_to,
+                   filter_scratch);
+        generation_source = generation_target;
+    }
+}
+
+void
+step_grid_rows_tiled(temporal_tiling_t *tiling, unsigned int worker_index, grid_t *grid, box_filter_t box_filter,
+                     box_filter_scratch_t *filter_scratch, int row_from, int row_to) {
+    Uint8 *scratch = tiling->scratch[worker_index];
+    for (int tile_from = row_from; tile_from < row_to; tile_from += tiling->tile_rows) {
+        int tile_to = SDL_min(tile_from + tiling->tile_rows, row_to);
+        if (grid->layout == GRID_LAYOUT_INTERLEAVED) {
+            advance_tile(grid->current[0], grid->next[0], grid->width, grid->height, CHANNELS_NUMBER, box_filter,
+                         filter_scratch, tiling->generations, tile_from, tile_to, scratch, tiling->scratch_size);
+        } else {
+            for (int channel = 0; channel < CHANNELS_NUMBER; channel++) {
+                advance_tile(grid->current[channel], grid->next[channel], grid->width, grid->height, 1, box_filter,
+                             filter_scratch, tiling->generations, tile_from, tile_to, scratch, tiling->scratch_size);
+            }
+        }
+    }
+}
+
+void
+destroy_temporal_tiling(temporal_tiling_t **pp_tiling) {
+    temporal_tiling_t *tiling = *pp_tiling;
+    if (tiling == NULL) {
+        return;
+    }
+    for (unsigned int i = 0; i < tiling->workers_number; i++) {
+        SDL_SIMDFree(tiling->scratch[i]);
+    }
+    free(tiling->scratch);
+    free(tiling);
+    *pp_tiling = NULL;
+}
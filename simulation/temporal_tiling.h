@@ -0,0 +1,40 @@
+#ifndef SDL_TEST_TEMPORAL_TILING_H
+#define SDL_TEST_TEMPORAL_TILING_H
+
+#include "grid.h"
+#include "box_filter.h"
+
+#define TEMPORAL_TILING_DEFAULT_CACHE_SIZE (256 * 1024)
+#define TEMPORAL_TILING_MIN_TILE_ROWS 8
+
+/**
+ * Advancing several generations per tile of rows before moving to the next tile. Each tile reads its rows plus
+ * a halo of one row per generation on both sides and computes a shrinking (trapezoid) range of rows per generation in
+ * per-worker scratch buffers, so intermediate generations stay in cache and never touch the grid.
+ * Halo rows are computed redundantly by neighbour tiles, the result is the same as stepping generation by generation.
+ */
+typedef struct temporal_tiling {
+    int generations;
+    int tile_rows;
+    /**
+     * size of one of two scratch buffers of a worker
+     */
+    size_t scratch_size;
+    unsigned int workers_number;
+    Uint8 **scratch;
+} temporal_tiling_t;
+
+/**
+ * Sizes tiles so a tile with halos and its scratch buffers fit the L2 cache and allocates scratch for every worker
+ */
+temporal_tiling_t *create_temporal_tiling(const grid_t *grid, int generations, unsigned int workers_number);
+
+/**
+ * Computes rows [row_from, row_to) of the next buffers of the grid, generations ahead of the current ones
+ */
+void step_grid_rows_tiled(temporal_tiling_t *tiling, unsigned int worker_index, grid_t *grid, box_filter_t box_filter,
+                          box_filter_scratch_t *filter_scratch, int row_from, int row_to);
+
+void destroy_temporal_tiling(temporal_tiling_t **pp_tiling);
+
+#endif //SDL_TEST_TEMPORAL_TILING_H
@@ -0,0 +1,80 @@
+#include "viewport.h"
+#include <SDL2/SDL.h>
+
+static double
+get_zoom(int zoom_level) {
+    return zoom_level >= 0 ? (double) (1 << zoom_level) : 1.0 / (1 << -zoom_level);
+}
+
+static void
+clamp_viewport(viewport_t *viewport) {
+    double zoom = get_zoom(viewport->zoom_level);
+    double max_x = SDL_max(0.0, viewport->grid_width - viewport->window_width / zoom);
+    double max_y = SDL_max(0.0, viewport->grid_height - viewport->window_height / zoom);
+    viewport->x = SDL_clamp(viewport->x, 0.0, max_x);
+    viewport->y = SDL_clamp(viewport->y, 0.0, max_y);
+    viewport->moved = true;
+}
+
+void
+init_viewport(viewport_t *viewport, int window_width, int window_height, int grid_width, int grid_height) {
+    viewport->window_width = window_width;
+    viewport->window_height = window_height;
+    viewport->grid_width = grid_width;
+    viewport->grid_height = grid_height;
+    viewport->x = 0;
+    viewport->y = 0;
+    viewport->zoom_level = 0;
+    // zooming out is allowed until the whole grid fits the window
+    viewport->min_zoom_level = 0;
+    while ((grid_width >> -viewport->min_zoom_level) > window_width ||
+           (grid_height >> -viewport->min_zoom_level) > window_height) {
+        viewport->min_zoom_level--;
+    }
+    clamp_viewport(viewport);
+}
+
+void
+pan_viewport(viewport_t *viewport, int dx, int dy) {
+    double zoom = get_zoom(viewport->zoom_level);
+    viewport->x -= dx / zoom;
+    viewport->y -= dy / zoom;
+    clamp_viewport(viewport);
+}
+
+void
+zoom_viewport(viewport_t *viewport, int levels, int mouse_x, int mouse_y) {
+    double zoom = get_zoom(viewport->zoom_level);
+    double cell_x = viewport->x + mouse_x / zoom;
+    double cell_y = viewport->y + mouse_y / zoom;
+
+    viewport->zoom_level = SDL_clamp(viewport->zoom_level + levels, viewport->min_zoom_level,
+                                     VIEWPORT_MAX_ZOOM_LEVEL);
+    zoom = get_zoom(viewport->zoom_level);
+    viewport->x = cell_x - mouse_x / zoom;
+    viewport->y = cell_y - mouse_y / zoom;
+    clamp_viewport(viewport);
+}
+
+void
+get_viewport_region(const viewport_t *viewport, viewport_region_t *region) {
+    region->x = (int) viewport->x;
+    region->y = (int) viewport->y;
+    if (viewport->zoom_level >= 0) {
+        region->step = 1;
+        region->scale = 1 << viewport->zoom_level;
+        region->offset_x = -(int) ((viewport->x - region->x) * region->scale);
+        region->offset_y = -(int) ((viewport->y - region->y) * region->scale);
+    } else {
+        region->step = 1 << -viewport->zoom_level;
+        region->scale = 1;
+        region->offset_x = 0;
+        region->offset_y = 0;
+    }
+    int window_columns = (viewport->window_width - region->offset_x + region->scale - 1) / region->scale;
+    int window_rows = (viewport->window_height - region->offset_y + region->scale - 1) / region->scale;
+    int grid_columns = (viewport->grid_width - region->x + region->step - 1) / region->step;
+    int grid_rows = (viewport->grid_height - region->y + region->step - 1) / region->step;
+    region->columns = SDL_min(window_columns, grid_columns);
+    region->rows = SDL_min(window_rows, grid_rows);
+}
@@ -0,0 +1,63 @@
+#ifndef SDL_TEST_VIEWPORT_H
+#define SDL_TEST_VIEWPORT_H
+
+#include <stdbool.h>
+
+#define VIEWPORT_MAX_ZOOM_LEVEL 5
+
+/**
+ * Window into a grid which may be much larger than the window. Zoom level z shows 2^z screen pixels per cell when
+ * non-negative and every 2^-z cell per screen pixel otherwise, so presentation converts at most one cell per pixel
+ * whatever the grid size is.
+ */
+typedef struct viewport {
+    int window_width;
+    int window_height;
+    int grid_width;
+    int grid_height;
+    /**
+     * grid position of the top left window corner, in cells
+     */
+    double x;
+    double y;
+    int zoom_level;
+    int min_zoom_level;
+    /**
+     * set when the visible region changed, cleared by the presentation
+     */
+    bool moved;
+} viewport_t;
+
+/**
+ * Cells visible in the viewport: columns x rows cells taken every step cells from the cell x, y. Each of them is drawn
+ * as a square of scale screen pixels, the first one at offset_x, offset_y (partially visible cells go off the window).
+ */
+typedef struct viewport_region {
+    int x;
+    int y;
+    int columns;
+    int rows;
+    int step;
+    int scale;
+    int offset_x;
+    int offset_y;
+} viewport_region_t;
+
+/**
+ * Shows the top left corner of the grid cell to pixel
+ */
+void init_viewport(viewport_t *viewport, int window_width, int window_height, int grid_width, int grid_height);
+
+/**
+ * Drags the grid by the mouse movement in screen pixels
+ */
+void pan_viewport(viewport_t *viewport, int dx, int dy);
+
+/**
+ * Zooms in for positive levels and out for negative ones, keeping the cell under the mouse in place
+ */
+void zoom_viewport(viewport_t *viewport, int levels, int mouse_x, int mouse_y);
+
+void get_viewport_region(const viewport_t *viewport, viewport_region_t *region);
+
+#endif //SDL_TEST_VIEWPORT_H
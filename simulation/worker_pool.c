@@ -0,0 +1,125 @@
+#include "worker_pool.h"
+#include "../opengl/sdl_ext.h"
+
+typedef struct worker_thread_data {
+    worker_pool_t *pool;
+    unsigned int worker_index;
+} worker_thread_data_t;
+
+static int
+worker_thread(void *data) {
+    worker_thread_data_t *thread_data = data;
+    worker_pool_t *pool = thread_data->pool;
+    unsigned int worker_index = thread_data->worker_index;
+    free(thread_data);
+
+    unsigned int seen_generation = 0;
+    SDL_LockMutex(pool->mutex);
+    while (true) {
+        while (!pool->shutting_down && pool->generation == seen_generation) {
+            SDL_CondWait(pool->task_ready, pool->mutex);
+        }
+        if (pool->shutting_down) {
+            break;
+        }
+        seen_generation = pool->generation;
+        worker_task_t task = pool->task;
+        void *task_data = pool->task_data;
+        SDL_UnlockMutex(pool->mutex);
+
+        task(task_data, worker_index, pool->workers_number);
+
+        SDL_LockMutex(pool->mutex);
+        if (--pool->workers_busy == 0) {
+            SDL_CondSignal(pool->task_done);
+        }
+    }
+    SDL_UnlockMutex(pool->mutex);
+    return 0;
+}
+
+worker_pool_t *
+create_worker_pool(unsigned int workers_number) {
+    worker_pool_t *pool = calloc(1, sizeof(worker_pool_t));
+    SDL_ALLOC_CHECK(pool)
+    pool->workers_number = workers_number > 0 ? workers_number : 1;
+    if (pool->workers_number == 1) {
+        return pool;
+    }
+
+    pool->mutex = SDL_CreateMutex();
+    pool->task_ready = SDL_CreateCond();
+    pool->task_done = SDL_CreateCond();
+    if (pool->mutex == NULL || pool->task_ready == NULL || pool->task_done == NULL) {
+        SDL_Die("Failed to create worker pool synchronization: %s", SDL_GetError());
+    }
+
+    pool->threads = calloc(pool->workers_number - 1, sizeof(SDL_Thread *));
+    SDL_ALLOC_CHECK(pool->threads)
+    for (unsigned int i = 1; i < pool->workers_number; i++) {
+        worker_thread_data_t *thread_data = malloc(sizeof(worker_thread_data_t));
+        SDL_ALLOC_CHECK(thread_data)
+        thread_data->pool = pool;
+        thread_data->worker_index = i;
+        pool->threads[i - 1] = SDL_CreateThread(worker_thread, "worker", thread_data);
+        if (pool->threads[i - 1] == NULL) {
+            SDL_Die("Failed to create worker thread: %s", SDL_GetError());
+        }
+    }
+    return pool;
+}
+
+void
+run_worker_pool(worker_pool_t *pool, worker_task_t task, void *data) {
+    if (pool->workers_number == 1) {
+        task(data, 0, 1);
+        return;
+    }
+
+    SDL_LockMutex(pool->mutex);
+    pool->task = task;
+    pool->task_data = data;
+    pool->workers_busy = pool->workers_number - 1;
+    pool->generation++;
+    SDL_CondBroadcast(pool->task_ready);
+    SDL_UnlockMutex(pool->mutex);
+
+    task(data, 0, pool->workers_number);
+
+    SDL_LockMutex(pool->mutex);
+    while (pool->workers_busy > 0) {
+        SDL_CondWait(pool->task_done, pool->mutex);
+    }
+    SDL_UnlockMutex(pool->mutex);
+}
+
+void
+destroy_worker_pool(worker_pool_t **pp_pool) {
+    worker_pool_t *pool = *pp_pool;
+    if (pool == NULL) {
+        return;
+    }
+    if (pool->threads != NULL) {
+        SDL_LockMutex(pool->mutex);
+        pool->shutting_down = true;
+        SDL_CondBroadcast(pool->task_ready);
+        SDL_UnlockMutex(pool->mutex);
+
+        for (unsigned int i = 0; i < pool->workers_number - 1; i++) {
+            SDL_WaitThread(pool->threads[i], NULL);
+        }
+        free(pool->threads);
+        pool->threads = NULL;
+    }
+    if (pool->task_done) {
+        SDL_DestroyCond(pool->task_done);
+    }
+    if (pool->task_ready) {
+        SDL_DestroyCond(pool->task_ready);
+    }
+    if (pool->mutex) {
+        SDL_DestroyMutex(pool->mutex);
+    }
+    free(pool);
+    *pp_pool = NULL;
+}
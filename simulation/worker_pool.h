@@ -0,0 +1,41 @@
+#ifndef SDL_TEST_WORKER_POOL_H
+#define SDL_TEST_WORKER_POOL_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+/**
+ * Piece of work for a single worker, workers are numbered from 0 to workers_number - 1
+ */
+typedef void (*worker_task_t)(void *data, unsigned int worker_index, unsigned int workers_number);
+
+typedef struct worker_pool {
+    unsigned int workers_number;
+    SDL_Thread **threads;
+    SDL_mutex *mutex;
+    SDL_cond *task_ready;
+    SDL_cond *task_done;
+    /**
+     * incremented for every submitted task, so sleeping workers can tell a new task from a spurious wake up
+     */
+    unsigned int generation;
+    unsigned int workers_busy;
+    bool shutting_down;
+    worker_task_t task;
+    void *task_data;
+} worker_pool_t;
+
+/**
+ * Creates a pool with workers_number workers. The calling thread is one of them, so workers_number - 1 threads are
+ * started.
+ */
+worker_pool_t *create_worker_pool(unsigned int workers_number);
+
+/**
+ * Runs the task on every worker and waits until all of them are done
+ */
+void run_worker_pool(worker_pool_t *pool, worker_task_t task, void *data);
+
+void destroy_worker_pool(worker_pool_t **pp_pool);
+
+#endif //SDL_TEST_WORKER_POOL_H